@@ -0,0 +1,58 @@
+// Shared by the grid shaders (vs_swe.sc draws the full grid, vs_swe_terrain.sc the level of detail patches)
+
+uniform vec4 u_gridData;
+uniform vec4 u_boundaryPos;
+uniform vec4 u_dataRanges;
+uniform vec4 u_util;
+uniform vec4 u_color1;
+uniform vec4 u_color2;
+uniform vec4 u_color3;
+uniform vec4 u_heightMapRange;
+uniform vec4 u_viewComposition;
+
+SAMPLER2D(s_heightMap, 0);  // Streamed values (h, hu, hv or the surface h + b of wet cells)
+SAMPLER2D(s_dryMask, 1);    // Static
+SAMPLER2D(s_bathymetry, 2); // Static
+
+#define gridSize   u_gridData.xy
+#define cellSize   u_gridData.zw
+#define gridOrigin u_boundaryPos.xz
+
+#define dataRangeWet u_dataRanges.xy
+#define dataRangeDry u_dataRanges.zw
+#define wetScale     u_util.x
+#define dryScale     u_util.y
+
+#define heightMapOffset  u_heightMapRange.x // Normalized texel formats store (z - offset) / scale
+#define heightMapScale   u_heightMapRange.y
+#define bathymetryOffset u_heightMapRange.z
+#define bathymetryScale  u_heightMapRange.w
+
+#define streamedWeight      u_viewComposition.x // Value of the view is streamed * streamedWeight + b * (dry ? dryBathymetryWeight : bathymetryWeight)
+#define bathymetryWeight    u_viewComposition.y
+#define dryBathymetryWeight u_viewComposition.z
+
+#define darkGreen vec4(0.15, 0.46, 0.42, 1.0)
+#define lightGrey vec4(0.62, 0.63, 0.63, 1.0)
+#define darkRed   vec4(0.67, 0.19, 0.07, 1.0)
+
+vec4 getColor(float z, vec2 range, vec4 c1, vec4 c2, vec4 c3) {
+  float t = clamp((z - range.x) / (range.y - range.x), 0.0, 1.0) * 2.0;
+  if (t < 1.0) {
+    return mix(c1, c2, t);
+  } else {
+    return mix(c2, c3, t - 1.0);
+  }
+}
+
+bool isDryCell(vec2 gridPos) {
+  return texture2DLod(s_dryMask, gridPos / gridSize, 0.0).r > 0.5;
+}
+
+// gridPos is the position in cells, cell centers are at .5
+float getValue(vec2 gridPos, bool dry) {
+  vec2  uv       = gridPos / gridSize;
+  float streamed = heightMapOffset + texture2DLod(s_heightMap, uv, 0.0).r * heightMapScale;
+  float b        = bathymetryOffset + texture2DLod(s_bathymetry, uv, 0.0).r * bathymetryScale;
+  return streamed * streamedWeight + b * (dry ? dryBathymetryWeight : bathymetryWeight);
+}
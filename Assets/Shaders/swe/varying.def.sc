@@ -1,3 +1,5 @@
 vec4 v_color0 : COLOR0 = vec4(0.0, 0.0, 0.0, 1.0);
 
-float a_position : POSITION;
+vec2 a_texcoord0 : TEXCOORD0;
+vec4 i_data0     : TEXCOORD7;
+vec4 i_data1     : TEXCOORD6;
@@ -0,0 +1,47 @@
+$input  a_texcoord0, i_data0, i_data1
+$output v_color0
+
+#include "common.sh"
+#include "swe.sh"
+
+#define PatchSize 32.0 // Terrain::PatchSize
+
+#define patchOrigin i_data0.xy // First cell of the patch
+#define patchStep   i_data0.z  // Cells per quad
+#define patchStitch i_data1    // Step ratio to a coarser neighbour (x: left, y: right, z: bottom, w: top)
+
+float snapTo(float v, float ratio) {
+  return floor(v / ratio) * ratio;
+}
+
+void main() {
+  vec2 local = a_texcoord0;
+
+  // Vertices on an edge to a coarser patch are moved onto its vertices, so that the edges match
+  if (local.x == 0.0) {
+    local.y = snapTo(local.y, patchStitch.x);
+  } else if (local.x == PatchSize) {
+    local.y = snapTo(local.y, patchStitch.y);
+  }
+  if (local.y == 0.0) {
+    local.x = snapTo(local.x, patchStitch.z);
+  } else if (local.y == PatchSize) {
+    local.x = snapTo(local.x, patchStitch.w);
+  }
+
+  // Patches at the upper grid border are clamped to the last cell
+  vec2 gridPos = min(patchOrigin + local * patchStep, gridSize - 1.0) + 0.5;
+
+  bool  dry = isDryCell(gridPos);
+  float z   = getValue(gridPos, dry);
+
+  if (!dry) {
+    v_color0 = getColor(z, dataRangeWet, u_color1, u_color2, u_color3);
+    z *= wetScale;
+  } else {
+    v_color0 = getColor(z, dataRangeDry, darkGreen, lightGrey, darkRed);
+    z *= dryScale;
+  }
+
+  gl_Position = mul(u_modelViewProj, vec4(gridOrigin + gridPos * cellSize, z, 1.0));
+}
@@ -0,0 +1,4 @@
+# Compresses INPUT into the gzip file OUTPUT, run with cmake -DINPUT=<file> -DOUTPUT=<file> -P CompressFile.cmake
+get_filename_component(OUTPUT_DIR "${OUTPUT}" DIRECTORY)
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+file(ARCHIVE_CREATE OUTPUT "${OUTPUT}" PATHS "${INPUT}" FORMAT raw COMPRESSION GZip COMPRESSION_LEVEL 9)
@@ -5,6 +5,11 @@ from dataclasses import dataclass
 from typing import Optional, Dict
 import inquirer
 
+# Tiled multi-resolution layout (version 2), see Source/Scenarios/GridFile.hpp
+TILED_MAGIC = b'SWET'
+TILED_VERSION = 2
+TILE_SIZE = 256
+
 @dataclass
 class GridConfig:
     nx: int
@@ -15,6 +20,7 @@ class GridConfig:
     domain_height: float  # in meters
     input_file: str
     output_file: str
+    tiled: bool = False
 
 @dataclass
 class ScenarioConfig:
@@ -69,7 +75,8 @@ def get_effective_config(grid_config: GridConfig, info: DatasetInfo) -> GridConf
         domain_width=info.width if grid_config.domain_width == 0 else grid_config.domain_width,
         domain_height=info.height if grid_config.domain_height == 0 else grid_config.domain_height,
         input_file=grid_config.input_file,
-        output_file=grid_config.output_file
+        output_file=grid_config.output_file,
+        tiled=grid_config.tiled
     )
 
 def convert_netcdf_to_binary(grid_config: GridConfig) -> Dict[str, float]:
@@ -103,11 +110,14 @@ def convert_netcdf_to_binary(grid_config: GridConfig) -> Dict[str, float]:
                 orig_j >= 0 and orig_j < len(info.y)):
                 z_new[j, i] = info.z[orig_j, orig_i]
     
-    with open(config.output_file, 'wb') as f:
-        f.write(struct.pack('II', config.nx, config.ny))
-        f.write(struct.pack('dd', config.origin_x, config.origin_y))
-        f.write(struct.pack('dd', cell_size_x, cell_size_y))
-        z_new.astype(np.float32).tofile(f)
+    if config.tiled:
+        write_tiled(config.output_file, z_new, config.origin_x, config.origin_y, cell_size_x, cell_size_y)
+    else:
+        with open(config.output_file, 'wb') as f:
+            f.write(struct.pack('II', config.nx, config.ny))
+            f.write(struct.pack('dd', config.origin_x, config.origin_y))
+            f.write(struct.pack('dd', cell_size_x, cell_size_y))
+            z_new.astype(np.float32).tofile(f)
     
     return {
         'x_min': config.origin_x,
@@ -116,6 +126,68 @@ def convert_netcdf_to_binary(grid_config: GridConfig) -> Dict[str, float]:
         'y_max': y_max
     }
 
+def build_pyramid(z: np.ndarray) -> list[np.ndarray]:
+    """Returns z followed by successively 2x2-averaged levels down to a single tile.
+
+    Odd sizes are padded by replicating the last row/column, so a coarser level extends past the previous one.
+    """
+    levels = [z.astype(np.float32)]
+    while levels[-1].shape[0] > TILE_SIZE or levels[-1].shape[1] > TILE_SIZE:
+        prev = levels[-1]
+        if min(prev.shape) < 4:
+            break
+        padded = np.pad(prev, ((0, prev.shape[0] % 2), (0, prev.shape[1] % 2)), mode='edge')
+        coarse = padded.reshape(padded.shape[0] // 2, 2, padded.shape[1] // 2, 2).mean(axis=(1, 3))
+        levels.append(coarse.astype(np.float32))
+    return levels
+
+def write_tiled(output_file: str, z: np.ndarray, origin_x: float, origin_y: float, dx: float, dy: float):
+    levels = build_pyramid(z)
+
+    # All levels start at the lower corner of level 0 and double the cell size, so they stay registered to it
+    # (a level padded to an even size covers more than the previous one, readers clip it to the extent of level 0).
+    # Origins refer to the center of the first cell
+    lower_x = origin_x - dx / 2.0
+    lower_y = origin_y - dy / 2.0
+
+    header_size = struct.calcsize('<4sIII')
+    level_header_size = struct.calcsize('<IIddddIIQ')
+    tile_bytes = TILE_SIZE * TILE_SIZE * 4
+
+    level_headers = []
+    offset = header_size + level_header_size * len(levels)
+    for index, level in enumerate(levels):
+        ny, nx = level.shape
+        tiles_x = (nx + TILE_SIZE - 1) // TILE_SIZE
+        tiles_y = (ny + TILE_SIZE - 1) // TILE_SIZE
+        level_dx = dx * 2 ** index
+        level_dy = dy * 2 ** index
+        level_headers.append(struct.pack('<IIddddIIQ', nx, ny,
+                                         lower_x + level_dx / 2.0, lower_y + level_dy / 2.0,
+                                         level_dx, level_dy, tiles_x, tiles_y, offset))
+        offset += 8 * tiles_x * tiles_y + tile_bytes * tiles_x * tiles_y
+
+    with open(output_file, 'wb') as f:
+        f.write(struct.pack('<4sIII', TILED_MAGIC, TILED_VERSION, TILE_SIZE, len(levels)))
+        for level_header in level_headers:
+            f.write(level_header)
+
+        for level in levels:
+            ny, nx = level.shape
+            tiles_x = (nx + TILE_SIZE - 1) // TILE_SIZE
+            tiles_y = (ny + TILE_SIZE - 1) // TILE_SIZE
+            # Pad edge tiles by replicating the last row/column
+            padded = np.pad(level, ((0, tiles_y * TILE_SIZE - ny), (0, tiles_x * TILE_SIZE - nx)), mode='edge')
+
+            tile_data_offset = f.tell() + 8 * tiles_x * tiles_y
+            f.write(struct.pack(f'<{tiles_x * tiles_y}Q', *[tile_data_offset + t * tile_bytes for t in range(tiles_x * tiles_y)]))
+            for ty in range(tiles_y):
+                for tx in range(tiles_x):
+                    tile = padded[ty * TILE_SIZE:(ty + 1) * TILE_SIZE, tx * TILE_SIZE:(tx + 1) * TILE_SIZE]
+                    np.ascontiguousarray(tile, dtype='<f4').tofile(f)
+
+    print(f"  Tiled: {len(levels)} levels, {TILE_SIZE}x{TILE_SIZE} tiles")
+
 def get_scenario_configs() -> list[ScenarioConfig]:
     return [
         ScenarioConfig(
@@ -180,8 +252,16 @@ def main():
                      choices=[s.name for s in scenarios])
     ]
     
+    questions.append(
+        inquirer.List('layout',
+                     message="Select output layout",
+                     choices=['Flat (v1)', 'Tiled pyramid (v2)'])
+    )
+
     answers = inquirer.prompt(questions)
     selected = next(s for s in scenarios if s.name == answers['scenario'])
+    selected.bath_config.tiled = answers['layout'] != 'Flat (v1)'
+    selected.displ_config.tiled = selected.bath_config.tiled
     
     convert_netcdf_to_binary(selected.bath_config)
     convert_netcdf_to_binary(selected.displ_config)
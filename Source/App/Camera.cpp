@@ -1,5 +1,6 @@
 #include "Camera.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include "Core/Input.hpp"
@@ -130,6 +131,17 @@ namespace App {
     }
 
     bgfx::setViewTransform(viewId, view, proj);
+
+    bx::mtxMul(m_viewProjection, view, proj);
+    m_eye             = eye;
+    m_projectionScale = proj[5] * (float)m_windowSize.y * 0.5f;
+  }
+
+  float Camera::getPixelsPerUnit(float distance) const {
+    if (m_type == Type::Orthographic) {
+      return m_projectionScale;
+    }
+    return m_projectionScale / std::max(distance, m_cameraClipping.x);
   }
 
   Vec3f Camera::forward() {
@@ -18,6 +18,13 @@ namespace App {
     Vec3f getTargetOffset() const { return m_targetOffset; }
     float getZoom() const { return m_zoom; }
 
+    /// View projection matrix of the last applyViewProjection
+    const float* getViewProjection() const { return m_viewProjection; }
+    Vec3f        getEye() const { return m_eye; }
+
+    /// Screen size in pixels of a world space length at the given distance from the eye
+    float getPixelsPerUnit(float distance) const;
+
     void setType(Type type) { m_type = type; }
     void setMouseOverUI(bool mouseOverUI) { m_mouseOverUI = mouseOverUI; }
     void setTargetCenter(Vec3f center) { m_targetCenter = center; }
@@ -56,6 +63,10 @@ namespace App {
 
     float m_zoom = 1.0f;
 
+    float m_viewProjection[16] = {};
+    Vec3f m_eye;
+    float m_projectionScale = 1.0f; // Pixels per world unit at distance 1 (at any distance for orthographic)
+
     bx::Quaternion m_orientation = bx::InitIdentity;
 
   private:
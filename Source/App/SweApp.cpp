@@ -2,22 +2,43 @@
 
 #include <algorithm>
 #include <bx/math.h>
+#include <cstdio>
 #include <filesystem>
 #include <imgui.h>
 #include <iostream>
 #include <limits>
+#include <numeric>
 
 #include "Blocks/DimensionalSplitting.hpp"
+#include "Core/Assets.hpp"
+#include "Core/Isa.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/Profiler.hpp"
+#include "Core/Trace.hpp"
 #include "Scenarios/ArtificialTsunamiScenario.hpp"
 #include "Scenarios/NetCDFScenario.hpp"
 #include "Scenarios/RealisticScenario.hpp"
 #include "Scenarios/TestScenario.hpp"
 #include "Shaders/swe/fs_swe.bin.h"
 #include "Shaders/swe/vs_swe.bin.h"
+#include "Shaders/swe/vs_swe_terrain.bin.h"
 #include "Utils.hpp"
 
+#define SWE_GRID_TRISTRIP 0
+
 namespace App {
 
+  static constexpr bgfx::TextureFormat::Enum HeightMapTextureFormats[] = {
+    bgfx::TextureFormat::R32F, // HeightMapFormat::R32F
+    bgfx::TextureFormat::R16F, // HeightMapFormat::R16F
+    bgfx::TextureFormat::R16,  // HeightMapFormat::R16
+    bgfx::TextureFormat::R8,   // HeightMapFormat::R8
+  };
+  static_assert(sizeof(HeightMapTextureFormats) / sizeof(HeightMapTextureFormats[0]) == (size_t)HeightMapFormat::Count);
+
+  // Largest grid dimension whose full index buffer is drawn, level of detail is limited by the texture size only
+  static constexpr int MaxFullGridDimension = 2000;
+
   SweApp::SweApp():
     Core::Application("Swe", 1280, 720) {
 
@@ -27,7 +48,12 @@ namespace App {
       return;
     }
 
-    CellVertex::init();
+    m_terrainProgram = bgfx::createProgram(bgfx::createShader(bgfx::makeRef(vs_swe_terrain, sizeof(vs_swe_terrain))), bgfx::createShader(bgfx::makeRef(fs_swe, sizeof(fs_swe))), true);
+
+    m_terrain.create();
+
+    m_terrainLodSupported = bgfx::isValid(m_terrainProgram) && (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING);
+    m_terrainLod          = m_terrainLodSupported;
 
     u_gridData    = bgfx::createUniform("u_gridData", bgfx::UniformType::Vec4);
     u_boundaryPos = bgfx::createUniform("u_boundaryPos", bgfx::UniformType::Vec4);
@@ -37,6 +63,11 @@ namespace App {
     u_color2      = bgfx::createUniform("u_color2", bgfx::UniformType::Vec4);
     u_color3      = bgfx::createUniform("u_color3", bgfx::UniformType::Vec4);
     s_heightMap   = bgfx::createUniform("u_heightMap", bgfx::UniformType::Sampler);
+    s_dryMask     = bgfx::createUniform("s_dryMask", bgfx::UniformType::Sampler);
+    s_bathymetry  = bgfx::createUniform("s_bathymetry", bgfx::UniformType::Sampler);
+
+    u_heightMapRange  = bgfx::createUniform("u_heightMapRange", bgfx::UniformType::Vec4);
+    u_viewComposition = bgfx::createUniform("u_viewComposition", bgfx::UniformType::Vec4);
 
     bgfx::setViewClear(m_mainView, m_clearFlags, colorToInt(m_clearColor));
 
@@ -45,6 +76,8 @@ namespace App {
   }
 
   SweApp::~SweApp() {
+    m_loadJob.reset(); // Cancels and waits for a running job
+
     if (isBlockLoaded()) {
       destroyBlock();
     }
@@ -52,11 +85,15 @@ namespace App {
   }
 
   void SweApp::update(float dt) {
+    SWE_TRACE_ZONE("Update");
+
+    finishLoadJob();
+    updateGrid(); // Values of the last step, the next one is computed while the frame is rendered
     simulate(dt);
-    updateGrid();
     updateControls(dt);
     updateCamera();
     render();
+    finishSimulation();
   }
 
   void SweApp::updateImGui(float dt) {
@@ -76,19 +113,21 @@ namespace App {
   void SweApp::destroyBlock() {
     delete m_scenario;
     delete m_block;
-    delete m_vertices;
-    delete m_indices;
-    delete m_heightMapData;
-
-    m_block         = nullptr;
-    m_scenario      = nullptr;
-    m_vertices      = nullptr;
-    m_indices       = nullptr;
-    m_heightMapData = nullptr;
-
-    bgfx::destroy(m_vbh);
-    bgfx::destroy(m_ibh);
-    bgfx::destroy(m_heightMap);
+    delete[] m_dryMaskData;
+    delete[] m_indices;
+
+    m_block       = nullptr;
+    m_scenario    = nullptr;
+    m_dryMaskData = nullptr;
+    m_indices     = nullptr;
+    m_indexCount  = 0;
+
+    if (bgfx::isValid(m_ibh)) {
+      bgfx::destroy(m_ibh);
+      m_ibh = BGFX_INVALID_HANDLE;
+    }
+    bgfx::destroy(m_dryMask);
+    destroyHeightMap();
   }
 
   void SweApp::destroyProgram() {
@@ -99,59 +138,42 @@ namespace App {
     bgfx::destroy(u_color1);
     bgfx::destroy(u_color2);
     bgfx::destroy(u_color3);
+    bgfx::destroy(u_heightMapRange);
+    bgfx::destroy(u_viewComposition);
     bgfx::destroy(s_heightMap);
+    bgfx::destroy(s_dryMask);
+    bgfx::destroy(s_bathymetry);
+
+    m_terrain.destroy();
 
     bgfx::destroy(m_program);
+    if (bgfx::isValid(m_terrainProgram)) {
+      bgfx::destroy(m_terrainProgram);
+    }
   }
 
-  bool SweApp::loadScenario() {
-    switch (m_scenarioType) {
+  Scenarios::Scenario* SweApp::createScenario(LoadJob& job) {
+    switch (job.scenarioType) {
 #ifdef ENABLE_NETCDF
-    case ScenarioType::NetCDF: {
-      m_scenario = new Scenarios::NetCDFScenario(m_bathymetryFile, m_displacementFile, m_boundaryType);
-      break;
-    }
+    case ScenarioType::NetCDF:
+      return new Scenarios::NetCDFScenario(job.bathymetryFile, job.displacementFile, job.boundaryType, job.dimensions.x, job.dimensions.y, &job.progress);
 #endif
-    case ScenarioType::Tohoku: {
-      m_scenario = new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::Tohoku, m_boundaryType);
-      break;
-    }
-    case ScenarioType::TohokuZoomed: {
-      m_scenario = new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::TohokuZoomed, m_boundaryType);
-      break;
-    }
-    case ScenarioType::Chile: {
-      m_scenario = new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::Chile, m_boundaryType);
-      break;
-    }
-    case ScenarioType::ArtificialTsunami: {
-      m_scenario = new Scenarios::ArtificialTsunamiScenario(m_boundaryType);
-      break;
-    }
+    case ScenarioType::Tohoku:
+      return new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::Tohoku, job.boundaryType, job.dimensions.x, job.dimensions.y, job.resampleMode);
+    case ScenarioType::TohokuZoomed:
+      return new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::TohokuZoomed, job.boundaryType, job.dimensions.x, job.dimensions.y, job.resampleMode);
+    case ScenarioType::Chile:
+      return new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::Chile, job.boundaryType, job.dimensions.x, job.dimensions.y, job.resampleMode);
+    case ScenarioType::ArtificialTsunami:
+      return new Scenarios::ArtificialTsunamiScenario(job.boundaryType);
 #ifndef NDEBUG
-    case ScenarioType::Test: {
-      m_scenario = new Scenarios::TestScenario(m_boundaryType, m_dimensions.x);
-      break;
-    }
+    case ScenarioType::Test:
+      return new Scenarios::TestScenario(job.boundaryType, job.dimensions.x);
 #endif
-    case ScenarioType::None: {
-      setNoneScenario();
-      m_message = "";
-      break;
-    }
     default:
       assert(false);
-      break;
+      return nullptr;
     }
-
-    if (m_scenario && !m_scenario->loadSuccess()) {
-      delete m_scenario;
-      m_scenario = nullptr;
-      setNoneScenario();
-      warn("Failed loading scenario");
-    }
-
-    return m_scenarioType != ScenarioType::None;
   }
 
   void SweApp::setNoneScenario() {
@@ -163,15 +185,142 @@ namespace App {
     m_util         = {};
   }
 
-  bool SweApp::initializeBlock(bool silent) {
+  LoadJob::~LoadJob() {
+    progress.cancel();
+    if (thread.joinable()) {
+      thread.join();
+    }
+
+    // Results that were not swapped into the app
+    delete scenario;
+    delete block;
+    delete[] dryMask;
+    delete[] indices;
+  }
+
+  void SweApp::runLoadJob(LoadJob& job) {
+    SWE_TRACE_ZONE("Load Job");
+
+    // Reading the data files, sampling the scenario and building the grid, the progress bar ends at the given fractions
+    job.progress.beginStage(0.4f);
+    job.scenario = createScenario(job);
+
+    if (job.scenario && job.scenario->loadSuccess() && !job.progress.isCancelled()) {
+      RealType left   = job.scenario->getBoundaryPos(BoundaryEdge::Left);
+      RealType right  = job.scenario->getBoundaryPos(BoundaryEdge::Right);
+      RealType bottom = job.scenario->getBoundaryPos(BoundaryEdge::Bottom);
+      RealType top    = job.scenario->getBoundaryPos(BoundaryEdge::Top);
+
+      int      nx = job.dimensions.x;
+      int      ny = job.dimensions.y;
+      RealType dx = (right - left) / RealType(nx);
+      RealType dy = (top - bottom) / RealType(ny);
+
+      job.progress.beginStage(0.9f);
+      auto* block = new Blocks::DimensionalSplittingBlock(nx, ny, dx, dy);
+      job.block   = block;
+      block->initialiseScenario(left, bottom, *job.scenario, &job.progress);
+
+      if (!job.progress.isCancelled()) {
+        block->setSparseTiles(true); // The bathymetry stays the same when the simulation is reset
+        block->setBathymetryFormat(job.bathymetryFormat);
+        block->setGhostLayer();
+
+        job.progress.beginStage(1.0f);
+        job.success = buildGrid(job);
+      }
+    }
+
+    job.finished = true;
+  }
+
+  bool SweApp::buildGrid(LoadJob& job) {
+    Vec2i n = job.dimensions;
+
+    job.progress.addWork(job.buildIndices ? 2 * n.y : n.y); // The indices count as much as the dry mask
+
+    job.dryMask = new uint8_t[n.x * n.y];
+
+    for (int j = 0; j < n.y; j++) {
+      for (int i = 0; i < n.x; i++) {
+        job.dryMask[j * n.x + i] = job.block->getBathymetry()[j + 1][i + 1] > RealType(0) ? 255 : 0;
+      }
+      if (!job.progress.advance()) {
+        return false;
+      }
+    }
+
+    if (job.buildIndices) {
+      job.indices = buildGridIndices(n, job.indexCount);
+      job.progress.advance(n.y);
+    }
+    return !job.progress.isCancelled();
+  }
+
+  uint32_t* SweApp::buildGridIndices(Vec2i n, int& indexCount) {
+#if SWE_GRID_TRISTRIP
+    uint32_t* indices = new uint32_t[2 * (n.x + 1) * (n.y - 1) - 2];
+    int       index   = 0;
+
+    for (int j = 0; j < n.y - 1; j++) {
+      for (int i = 0; i < n.x; i++) {
+        indices[index++] = j * n.x + i;
+        indices[index++] = (j + 1) * n.x + i;
+      }
+      if (j < n.y - 2) {
+        indices[index++] = (j + 1) * n.x + (n.x - 1);
+        indices[index++] = (j + 1) * n.x;
+      }
+    }
+    assert(index == 2 * (n.x + 1) * (n.y - 1) - 2);
+#else // TriList
+    uint32_t* indices = new uint32_t[6 * (n.x - 1) * (n.y - 1)];
+    int       index   = 0;
+
+    for (int j = 0; j < n.y - 1; j++) {
+      for (int i = 0; i < n.x - 1; i++) {
+        uint32_t topLeft     = j * n.x + i;
+        uint32_t topRight    = topLeft + 1;
+        uint32_t bottomLeft  = (j + 1) * n.x + i;
+        uint32_t bottomRight = bottomLeft + 1;
+        indices[index++]     = topLeft;
+        indices[index++]     = bottomLeft;
+        indices[index++]     = topRight;
+        indices[index++]     = topRight;
+        indices[index++]     = bottomLeft;
+        indices[index++]     = bottomRight;
+      }
+    }
+    assert(index == 6 * (n.x - 1) * (n.y - 1));
+#endif
+
+    indexCount = index;
+    return indices;
+  }
+
+  void SweApp::swapInLoadJob() {
+    LoadJob& job = *m_loadJob;
+
     if (isBlockLoaded()) {
       destroyBlock();
     }
 
-    bool loaded = loadScenario();
-    if (!loaded) {
-      return false;
-    }
+    m_scenarioType          = job.scenarioType;
+    m_dimensions            = job.dimensions;
+    m_simulationTime        = 0.0;
+    m_playing               = false;
+    m_showScenarioSelection = false;
+
+    // Take ownership of the results
+    m_scenario    = job.scenario;
+    m_block       = job.block;
+    m_dryMaskData = job.dryMask;
+    m_indices     = job.indices;
+
+    job.scenario = nullptr;
+    job.block    = nullptr;
+    job.dryMask  = nullptr;
+    job.indices  = nullptr;
 
     RealType left   = m_scenario->getBoundaryPos(BoundaryEdge::Left);
     RealType right  = m_scenario->getBoundaryPos(BoundaryEdge::Right);
@@ -182,8 +331,8 @@ namespace App {
 
     int      nx = m_dimensions.x;
     int      ny = m_dimensions.y;
-    RealType dx = (right - left) / RealType(nx);
-    RealType dy = (top - bottom) / RealType(ny);
+    RealType dx = m_block->getDx();
+    RealType dy = m_block->getDy();
 
     m_gridData = {(float)nx, (float)ny, (float)dx, (float)dy};
 
@@ -194,87 +343,216 @@ namespace App {
     std::cout << "  Left: " << left << ", Right: " << right << ", Bottom: " << bottom << ", Top: " << top << std::endl;
 #endif
 
-    m_block = new Blocks::DimensionalSplittingBlock(nx, ny, dx, dy);
-    m_block->initialiseScenario(left, bottom, *m_scenario);
-    m_block->setGhostLayer();
+    // The boundary may have been switched while loading
+    setBlockBoundaryType(m_block, m_boundaryType);
 
-    createGrid({nx, ny});
+    createGrid({nx, ny}, job.indexCount);
+    setTerrainLod(m_terrainLod); // Builds or frees the indices if the mode was switched while loading
 
-    if (!silent) {
+    if (!job.silent) {
       setColorAndValueScale();
       resetCamera();
       resetDisplacementData();
     }
 
     m_message = "";
+  }
 
-    return true;
+  void SweApp::createGrid(Vec2i n, int indexCount) {
+    m_indexCount = indexCount;
+    if (m_indices) {
+      m_ibh = bgfx::createIndexBuffer(bgfx::makeRef(m_indices, indexCount * sizeof(uint32_t)), BGFX_BUFFER_INDEX32);
+    }
+
+    // The vertices of the full grid are generated from gl_VertexID, the dry flags are read from a texture
+    m_dryMask = bgfx::createTexture2D(n.x, n.y, false, 1, bgfx::TextureFormat::R8, BGFX_TEXTURE_NONE, bgfx::makeRef(m_dryMaskData, n.x * n.y));
+
+#if SWE_GRID_TRISTRIP
+    m_stateFlags |= BGFX_STATE_PT_TRISTRIP;
+#else
+    m_stateFlags &= ~BGFX_STATE_PT_TRISTRIP;
+#endif
+
+    createHeightMap();
   }
 
-  void SweApp::createGrid(Vec2i n) {
-    m_vertices = new CellVertex[n.x * n.y];
+  void SweApp::createHeightMap() {
+    int nx = m_dimensions.x;
+    int ny = m_dimensions.y;
 
-    for (int j = 0; j < n.y; j++) {
-      for (int i = 0; i < n.x; i++) {
-        m_vertices[j * n.x + i].isDry = m_block->getBathymetry()[j + 1][i + 1] > RealType(0) ? 255 : 0;
-      }
+    bgfx::TextureFormat::Enum textureFormat = HeightMapTextureFormats[(int)m_heightMapFormat];
+    int                       texelSize     = getHeightMapTexelSize(m_heightMapFormat);
+
+    m_heightMap     = bgfx::createTexture2D(nx, ny, false, 1, textureFormat, BGFX_TEXTURE_NONE);
+    m_heightMapData = new uint8_t[nx * ny * texelSize];
+
+    // Normalized formats get the range of the streamed values on the first upload
+    m_heightMapRange = {0.0f, 1.0f, 0.0f, 1.0f};
+    if (m_heightMapFormat == HeightMapFormat::R16 || m_heightMapFormat == HeightMapFormat::R8) {
+      Vec2f wet, dry;
+      computeViewRanges(m_block, ViewType::B, m_dryMaskData, wet, dry);
+      m_heightMapRange.z = std::min(wet.x, dry.x);
+      m_heightMapRange.w = std::max(std::max(wet.y, dry.y) - m_heightMapRange.z, 0.01f);
     }
 
-#if 0 // TriStrip
-    m_indices = new uint32_t[2 * (n.x + 1) * (n.y - 1) - 2];
-    int index = 0;
+    // The bathymetry is static, so it is encoded and uploaded once
+    const Float2D<RealType>& b      = m_block->getBathymetry();
+    const bgfx::Memory*      texels = bgfx::alloc(nx * ny * texelSize);
+    Vec2i                    dirtyMin, dirtyMax;
+    encodeHeightMap(m_heightMapFormat, b[1] + 1, nullptr, b.getStride(), nullptr, nx, ny, m_heightMapRange.z, m_heightMapRange.w, texels->data, dirtyMin, dirtyMax);
+    m_bathymetry = bgfx::createTexture2D(nx, ny, false, 1, textureFormat, BGFX_TEXTURE_NONE, texels);
 
-    for (int j = 0; j < n.y - 1; j++) {
-      for (int i = 0; i < n.x; i++) {
-        m_indices[index++] = j * n.x + i;
-        m_indices[index++] = (j + 1) * n.x + i;
-      }
-      if (j < n.y - 2) {
-        m_indices[index++] = (j + 1) * n.x + (n.x - 1);
-        m_indices[index++] = (j + 1) * n.x;
-      }
+    m_gridDirty       = true;
+    m_viewRangesDirty = true;
+    m_uploadAll       = true;
+  }
+
+  void SweApp::destroyHeightMap() {
+    bgfx::destroy(m_heightMap);
+    bgfx::destroy(m_bathymetry);
+    delete[] m_heightMapData;
+    m_heightMapData = nullptr;
+  }
+
+  void SweApp::setHeightMapFormat(HeightMapFormat format) {
+    m_heightMapFormat = format;
+    if (isBlockLoaded()) {
+      destroyHeightMap();
+      createHeightMap();
     }
-    m_stateFlags |= BGFX_STATE_PT_TRISTRIP;
-    assert(index == 2 * (n.x + 1) * (n.y - 1) - 2);
-#else // TriList
-    m_indices = new uint32_t[6 * (n.x - 1) * (n.y - 1)];
-    int index = 0;
+  }
 
-    for (int j = 0; j < n.y - 1; j++) {
-      for (int i = 0; i < n.x - 1; i++) {
-        uint32_t topLeft     = j * n.x + i;
-        uint32_t topRight    = topLeft + 1;
-        uint32_t bottomLeft  = (j + 1) * n.x + i;
-        uint32_t bottomRight = bottomLeft + 1;
-        m_indices[index++]   = topLeft;
-        m_indices[index++]   = bottomLeft;
-        m_indices[index++]   = topRight;
-        m_indices[index++]   = topRight;
-        m_indices[index++]   = bottomLeft;
-        m_indices[index++]   = bottomRight;
+  void SweApp::setTerrainLod(bool enabled) {
+    m_terrainLod = enabled && m_terrainLodSupported;
+    if (!isBlockLoaded()) {
+      return;
+    }
+
+    if (m_terrainLod && m_indices) {
+      // The index buffer of the full grid is only kept while it is drawn
+      bgfx::destroy(m_ibh);
+      delete[] m_indices;
+      m_ibh        = BGFX_INVALID_HANDLE;
+      m_indices    = nullptr;
+      m_indexCount = 0;
+    } else if (!m_terrainLod && !m_indices) {
+      m_indices = buildGridIndices(m_dimensions, m_indexCount);
+      m_ibh     = bgfx::createIndexBuffer(bgfx::makeRef(m_indices, m_indexCount * sizeof(uint32_t)), BGFX_BUFFER_INDEX32);
+    }
+  }
+
+  bool SweApp::selectScenario(bool silentHint, std::function<void()> onFailure) {
+    if (m_loadJob) {
+      return false; // Only one scenario is loaded at a time
+    }
+
+    if (m_selectedScenarioType == ScenarioType::None) {
+      if (isBlockLoaded()) {
+        destroyBlock();
       }
+      setNoneScenario();
+      m_simulationTime        = 0.0;
+      m_playing               = false;
+      m_showScenarioSelection = false;
+      m_message               = "";
+      return true;
     }
-    m_stateFlags &= ~BGFX_STATE_PT_TRISTRIP;
-    assert(index == 6 * (n.x - 1) * (n.y - 1));
+
+    m_loadJob               = std::make_unique<LoadJob>();
+    m_loadJob->scenarioType     = m_selectedScenarioType;
+    m_loadJob->dimensions       = m_selectedDimensions;
+    m_loadJob->boundaryType     = m_boundaryType;
+    m_loadJob->resampleMode     = m_resampleMode;
+    m_loadJob->bathymetryFormat = m_bathymetryFormat;
+    m_loadJob->buildIndices     = !m_terrainLod;
+    m_loadJob->silent           = silentHint && m_scenarioType == m_selectedScenarioType && m_dimensions == m_selectedDimensions;
+    m_loadJob->onFailure        = std::move(onFailure);
+#ifdef ENABLE_NETCDF
+    m_loadJob->bathymetryFile   = m_bathymetryFile;
+    m_loadJob->displacementFile = m_displacementFile;
 #endif
 
-    m_vbh = bgfx::createVertexBuffer(bgfx::makeRef(m_vertices, n.x * n.y * sizeof(CellVertex)), CellVertex::layout);
-    m_ibh = bgfx::createIndexBuffer(bgfx::makeRef(m_indices, index * sizeof(uint32_t)), BGFX_BUFFER_INDEX32);
+    // Downloads the data files first in the web build, the job stays in place until the download finished
+    Core::fetchAssets(getAssetFiles(m_selectedScenarioType), [this](bool success) {
+      if (!success || m_loadJob->progress.isCancelled()) {
+        m_loadJob->finished = true;
+        return;
+      }
+      startLoadJob();
+    });
 
-    m_heightMap     = bgfx::createTexture2D(n.x, n.y, false, 1, bgfx::TextureFormat::R32F, BGFX_TEXTURE_NONE);
-    m_heightMapData = new float[n.x * n.y];
+    return true;
   }
 
-  bool SweApp::selectScenario(bool silentHint) {
-    bool silent = silentHint && m_scenarioType == m_selectedScenarioType && m_dimensions == m_selectedDimensions;
+  void SweApp::startLoadJob() {
+#ifdef SWE_NO_THREADS
+    runLoadJob(*m_loadJob); // Swapped in on the next frame
+#else
+    m_loadJob->thread = std::thread([&job = *m_loadJob] {
+      SWE_TRACE_THREAD("Loader");
+      runLoadJob(job);
+    });
+#endif
+  }
 
-    m_scenarioType          = m_selectedScenarioType;
-    m_dimensions            = m_selectedDimensions;
-    m_simulationTime        = 0.0;
-    m_playing               = false;
-    m_showScenarioSelection = false;
+  std::vector<std::string> SweApp::getAssetFiles(ScenarioType scenarioType) {
+    Scenarios::RealisticScenarioType realisticType;
+    switch (scenarioType) {
+    case ScenarioType::Tohoku:
+      realisticType = Scenarios::RealisticScenarioType::Tohoku;
+      break;
+    case ScenarioType::TohokuZoomed:
+      realisticType = Scenarios::RealisticScenarioType::TohokuZoomed;
+      break;
+    case ScenarioType::Chile:
+      realisticType = Scenarios::RealisticScenarioType::Chile;
+      break;
+    default:
+      return {};
+    }
 
-    return initializeBlock(silent);
+    std::string bathymetryFile, displacementFile;
+    Scenarios::RealisticScenario::getDataFiles(realisticType, bathymetryFile, displacementFile);
+    return {bathymetryFile, displacementFile};
+  }
+
+  void SweApp::cancelLoadJob() {
+    if (m_loadJob) {
+      m_loadJob->progress.cancel();
+    }
+  }
+
+  void SweApp::finishLoadJob() {
+    if (!m_loadJob || !m_loadJob->finished) {
+      return;
+    }
+
+    if (m_loadJob->thread.joinable()) {
+      m_loadJob->thread.join();
+    }
+
+    if (m_loadJob->progress.isCancelled()) {
+      m_message = "";
+    } else if (m_loadJob->success) {
+      swapInLoadJob();
+    } else {
+      warn("Failed loading scenario");
+      if (m_loadJob->onFailure) {
+        m_loadJob->onFailure();
+      }
+    }
+
+    m_loadJob.reset();
+
+#ifdef ENABLE_NETCDF
+    if (m_pendingNcLoad) {
+      PendingNcLoad pending = std::move(*m_pendingNcLoad);
+      m_pendingNcLoad.reset();
+      strncpy(m_bathymetryFile, pending.bathymetryFile.c_str(), sizeof(m_bathymetryFile) - 1);
+      strncpy(m_displacementFile, pending.displacementFile.c_str(), sizeof(m_displacementFile) - 1);
+      tryAutoLoadNcFiles(pending.dimensions, pending.silent);
+    }
+#endif
   }
 
   void SweApp::startStopSimulation() {
@@ -287,8 +565,15 @@ namespace App {
       return;
 
     m_block->initialiseScenario(m_block->getOffsetX(), m_block->getOffsetY(), *m_scenario);
-    m_simulationTime = 0.0;
-    m_playing        = false;
+
+    // Rounds the bathymetry of the scenario again, the app only creates dimensional splitting blocks
+    auto* block = static_cast<Blocks::DimensionalSplittingBlock*>(m_block);
+    block->setBathymetryFormat(block->getBathymetryFormat());
+
+    m_simulationTime  = 0.0;
+    m_playing         = false;
+    m_gridDirty       = true;
+    m_viewRangesDirty = true;
 
     setBlockBoundaryType(m_block, m_boundaryType);
   }
@@ -362,6 +647,8 @@ namespace App {
     m_util.x = m_viewType == ViewType::H || m_viewType == ViewType::B ? m_util.z : m_util.w;
 
     if (m_viewType != ViewType::HPlusB) {
+      m_gridDirty       = true;
+      m_viewRangesDirty = true;
       updateGrid();
       setWetDataRange();
     } else {
@@ -373,7 +660,9 @@ namespace App {
   }
 
   void SweApp::switchView(ViewType viewType) {
-    m_viewType = viewType;
+    m_viewType        = viewType;
+    m_gridDirty       = true;
+    m_viewRangesDirty = true;
     setColorAndValueScale(false);
     setCameraTargetCenter();
     m_message = "";
@@ -434,6 +723,9 @@ namespace App {
         return height;
       });
     }
+
+    m_gridDirty       = true;
+    m_viewRangesDirty = true;
   }
 
   void SweApp::warn(const char* message) {
@@ -446,14 +738,42 @@ namespace App {
       return;
     }
 
-    m_block->setGhostLayer();
-
     RealType scaleFactor = RealType(std::min(dt * m_timeScale, 1.0f));
 
-    m_block->computeMaxTimeStep();
-    RealType maxTimeStep = m_block->getMaxTimeStep();
-    maxTimeStep *= scaleFactor;
-    m_block->simulateTimeStep(maxTimeStep);
+    // The block is only used by the solver thread until finishSimulation()
+    m_stepRunning = true;
+    m_stepCount   = m_stepsPerFrame;
+    m_solverWorker.start([this, scaleFactor] {
+      SWE_TRACE_ZONE("Simulate");
+
+      {
+        SWE_PROFILE_SCOPE(GhostLayer);
+        m_block->setGhostLayer();
+      }
+
+      {
+        SWE_PROFILE_SCOPE(MaxTimeStep);
+        m_block->computeMaxTimeStep();
+      }
+      m_stepTime = m_block->getMaxTimeStep() * scaleFactor;
+      if (m_stepCount > 1) {
+        m_block->simulateTimeSteps(m_stepTime, m_stepCount);
+      } else {
+        m_block->simulateTimeStep(m_stepTime);
+      }
+    });
+  }
+
+  void SweApp::finishSimulation() {
+    if (!m_stepRunning) {
+      return;
+    }
+
+    {
+      SWE_TRACE_ZONE("Wait for Solver");
+      m_solverWorker.wait();
+    }
+    m_stepRunning = false;
 
     if (m_block->hasError()) {
       warn("Simulation crashed");
@@ -461,41 +781,111 @@ namespace App {
       return;
     }
 
-    m_simulationTime += (float)maxTimeStep;
+    m_simulationTime += float(m_stepTime * m_stepCount);
+    m_gridDirty = true;
+
+    Core::Profiler::addCount(Core::ProfileCounter::Cells, double(m_dimensions.x) * m_dimensions.y * m_stepCount);
+    Core::Profiler::addCount(Core::ProfileCounter::SimulatedTime, m_stepTime * m_stepCount);
   }
 
   void SweApp::updateGrid() {
-    if (!isBlockLoaded())
+    if (!isBlockLoaded() || !m_gridDirty)
       return;
 
+    m_gridDirty = false;
+
+    SWE_TRACE_ZONE("Update Grid");
+
     int nx = m_dimensions.x;
     int ny = m_dimensions.y;
 
-    Vec2f minMaxWet = {std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
-    Vec2f minMaxDry = {std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    // Ranges of the shown values are only needed for the colors, so they are not updated every frame
+    if (m_viewRangesDirty || m_autoScaleDataRange) {
+      SWE_PROFILE_SCOPE(UpdateGrid);
 
-    for (int j = 0; j < ny; j++) {
-      for (int i = 0; i < nx; i++) {
-        float value = (float)getBlockValue(m_block, m_viewType, i + 1, j + 1);
-        int   index = j * nx + i;
+      Vec2f minMaxDry;
+      computeViewRanges(m_block, m_viewType, m_dryMaskData, m_minMaxWet, minMaxDry);
 
-        if (!m_vertices[index].isDry) {
-          minMaxWet.x = std::min(minMaxWet.x, value);
-          minMaxWet.y = std::max(minMaxWet.y, value);
-        } else {
-          minMaxDry.x = std::min(minMaxDry.x, value);
-          minMaxDry.y = std::max(minMaxDry.y, value);
-        }
+      m_dataRanges.z    = minMaxDry.x;
+      m_dataRanges.w    = minMaxDry.y;
+      m_viewRangesDirty = false;
+    }
+
+    // The shader composes the view from the streamed values and the static bathymetry
+    ViewType streamedView = getStreamedView(m_viewType, m_heightMapFormat);
+    if (streamedView == ViewType::Count) {
+      if (!m_uploadAll) {
+        return;
+      }
+      streamedView = ViewType::H; // The height map is not shown but still needs valid content
+    }
+
+    // The streamed surface is h + b for wet cells and h for dry cells, whose bathymetry is added in the shader
+    bool                     surface  = streamedView == ViewType::HPlusB;
+    const Float2D<RealType>& values   = getBlockValues(m_block, surface ? ViewType::H : streamedView);
+    const RealType*          wetAdded = surface ? m_block->getBathymetry()[1] + 1 : nullptr;
+
+    if (m_heightMapFormat == HeightMapFormat::R16 || m_heightMapFormat == HeightMapFormat::R8) {
+      SWE_PROFILE_SCOPE(UpdateGrid);
 
-        m_heightMapData[index] = value;
+      Vec2f wet, dry;
+      computeViewRanges(m_block, streamedView, m_dryMaskData, wet, dry);
+      if (surface) {
+        Vec2f unused;
+        computeViewRanges(m_block, ViewType::H, m_dryMaskData, unused, dry);
+      }
+
+      // Keep the range while the values fit, so that unchanged cells keep their texels
+      float low    = std::min(wet.x, dry.x);
+      float high   = std::max(wet.y, dry.y);
+      float offset = m_heightMapRange.x;
+      float scale  = m_heightMapRange.y;
+      if (low < offset || high > offset + scale || (high - low) * 4.0f < scale) {
+        float margin       = (high - low) * 0.1f + 0.01f;
+        m_heightMapRange.x = low - margin;
+        m_heightMapRange.y = high - low + 2.0f * margin;
       }
     }
 
-    m_minMaxWet    = minMaxWet;
-    m_dataRanges.z = minMaxDry.x;
-    m_dataRanges.w = minMaxDry.y;
+    // Encoding and queueing the upload, the copy to the GPU happens in bgfx::frame()
+    SWE_PROFILE_SCOPE(TextureUpload);
+    SWE_TRACE_ZONE("Texture Upload");
+
+    Vec2i dirtyMin, dirtyMax;
+    bool  changed = encodeHeightMap(
+      m_heightMapFormat,
+      values[1] + 1,
+      wetAdded,
+      values.getStride(),
+      m_dryMaskData,
+      nx,
+      ny,
+      m_heightMapRange.x,
+      m_heightMapRange.y,
+      m_heightMapData,
+      dirtyMin,
+      dirtyMax
+    );
+
+    if (m_uploadAll) {
+      dirtyMin    = {0, 0};
+      dirtyMax    = {nx - 1, ny - 1};
+      changed     = true;
+      m_uploadAll = false;
+    }
+    if (!changed) {
+      return;
+    }
 
-    bgfx::updateTexture2D(m_heightMap, 0, 0, 0, 0, nx, ny, bgfx::makeRef(m_heightMapData, sizeof(float) * nx * ny));
+    // Upload the bounding rectangle of the changed texels only
+    int            texelSize = getHeightMapTexelSize(m_heightMapFormat);
+    int            width     = dirtyMax.x - dirtyMin.x + 1;
+    int            height    = dirtyMax.y - dirtyMin.y + 1;
+    int            pitch     = nx * texelSize;
+    const uint8_t* first     = m_heightMapData + (size_t)dirtyMin.y * pitch + dirtyMin.x * texelSize;
+    uint32_t       size      = uint32_t((height - 1) * pitch + width * texelSize);
+
+    bgfx::updateTexture2D(m_heightMap, 0, 0, dirtyMin.x, dirtyMin.y, width, height, bgfx::makeRef(first, size), pitch);
   }
 
   void SweApp::updateControls(float) {
@@ -526,28 +916,60 @@ namespace App {
     m_cameraClipping.y = m_camera.getZoom() * maxDim + std::max(maxDim, maxDist) + maxOffset * 2.0f;
 
     m_camera.applyViewProjection(m_mainView);
+
+    if (m_terrainLod) {
+      // Bounds of the drawn heights for culling the patches
+      float zWet[2] = {m_minMaxWet.x * m_util.x, m_minMaxWet.y * m_util.x};
+      float zDry[2] = {m_dataRanges.z * m_util.y, m_dataRanges.w * m_util.y};
+      Vec2f zRange  = {std::min({zWet[0], zWet[1], zDry[0], zDry[1]}), std::max({zWet[0], zWet[1], zDry[0], zDry[1]})};
+
+      Vec2f origin   = {m_boundaryPos.x, m_boundaryPos.z};
+      Vec2f cellSize = {m_gridData.z, m_gridData.w};
+      m_terrain.select(m_camera, m_dimensions, origin, cellSize, zRange, m_terrainDetail);
+    }
   }
 
   void SweApp::render() {
     bgfx::touch(m_mainView);
 
-    if (isBlockLoaded()) {
-      bgfx::setIndexBuffer(m_ibh);
-      bgfx::setVertexBuffer(0, m_vbh);
+    uint64_t            state   = m_stateFlags;
+    bgfx::ProgramHandle program = m_program;
+
+    // No patch is selected if the camera sees none of the domain, there is nothing to draw then
+    bool draw = !(isBlockLoaded() && m_terrainLod) || m_terrain.setBuffers();
+
+    if (isBlockLoaded() && draw) {
+      Vec4f viewComposition = getViewComposition(m_viewType, m_heightMapFormat);
+
+      if (m_terrainLod) {
+        state &= ~BGFX_STATE_PT_TRISTRIP; // Patches are triangle lists
+        program = m_terrainProgram;
+      } else {
+        bgfx::setIndexBuffer(m_ibh);
+        bgfx::setVertexCount(m_dimensions.x * m_dimensions.y);
+      }
       bgfx::setTexture(0, s_heightMap, m_heightMap);
+      bgfx::setTexture(1, s_dryMask, m_dryMask);
+      bgfx::setTexture(2, s_bathymetry, m_bathymetry);
 
       bgfx::setUniform(u_gridData, m_gridData);
       bgfx::setUniform(u_boundaryPos, m_boundaryPos);
       bgfx::setUniform(u_dataRanges, m_dataRanges);
       bgfx::setUniform(u_util, m_util);
+      bgfx::setUniform(u_heightMapRange, m_heightMapRange);
+      bgfx::setUniform(u_viewComposition, viewComposition);
       bgfx::setUniform(u_color1, m_color1);
       bgfx::setUniform(u_color2, m_color2);
       bgfx::setUniform(u_color3, m_color3);
     }
 
-    bgfx::setState(m_stateFlags);
-    bgfx::submit(m_mainView, m_program);
+    if (draw) {
+      bgfx::setState(state);
+      bgfx::submit(m_mainView, program);
+    }
 
+    SWE_PROFILE_SCOPE(Frame);
+    SWE_TRACE_ZONE("bgfx::frame");
     bgfx::frame();
   }
 
@@ -637,6 +1059,8 @@ namespace App {
     }
 
     ImGui::DragFloat("Time Scale", &m_timeScale, 0.1f, 0.0f, 1.0f / dt, "%.1f");
+    ImGui::SliderInt("Steps per Frame", &m_stepsPerFrame, 1, 16);
+    ImGui::SetItemTooltip("Steps of the same size, computed together in one pass over the grid (temporal blocking)");
 
     ImGui::SeparatorText("Visualization");
 
@@ -737,20 +1161,165 @@ namespace App {
     }
     ImGui::SetItemTooltip("Unhide windows with 'C'");
 
-#ifndef __EMSCRIPTEN__
     ImGui::SeparatorText("Performance");
 
+#ifndef __EMSCRIPTEN__
     if (ImGui::Checkbox("VSync", &m_vsyncEnabled)) {
       toggleVsync();
     }
+    ImGui::SameLine();
 #endif
 
-    ImGui::SameLine();
     ImGui::TextDisabled("FPS: %.0f", ImGui::GetIO().Framerate);
 
+    if (ImGui::BeginCombo("Height Map", heightMapFormatToString(m_heightMapFormat).c_str())) {
+      for (int i = 0; i < (int)HeightMapFormat::Count; i++) {
+        HeightMapFormat format    = (HeightMapFormat)i;
+        bool            supported = bgfx::getCaps()->formats[HeightMapTextureFormats[i]] & BGFX_CAPS_FORMAT_TEXTURE_VERTEX;
+        ImGui::BeginDisabled(!supported);
+        if (ImGui::Selectable(heightMapFormatToString(format).c_str(), m_heightMapFormat == format)) {
+          setHeightMapFormat(format);
+        }
+        ImGui::EndDisabled();
+      }
+      ImGui::EndCombo();
+    }
+    ImGui::SetItemTooltip("Texture format of the uploaded values, smaller formats need less bandwidth");
+
+    // A grid larger than MaxFullGridDimension is only drawn with level of detail
+    bool largeGrid = std::max(m_dimensions.x, m_dimensions.y) > MaxFullGridDimension;
+    ImGui::BeginDisabled(!m_terrainLodSupported || (m_terrainLod && largeGrid));
+    if (ImGui::Checkbox("Level of Detail", &m_terrainLod)) {
+      setTerrainLod(m_terrainLod);
+    }
+    ImGui::EndDisabled();
+    ImGui::SetItemTooltip("Draw the grid with a resolution depending on the distance to the camera (required above %d cells per axis)", MaxFullGridDimension);
+
+    if (m_terrainLod) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("Patches: %d", m_terrain.getPatchCount());
+      ImGui::SliderFloat("Detail (px)", &m_terrainDetail, 0.5f, 16.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+      ImGui::SetItemTooltip("Screen size of a drawn quad before the grid is refined");
+    }
+
+    if (ImGui::TreeNodeEx("Profiler", ImGuiTreeNodeFlags_FramePadding | ImGuiTreeNodeFlags_SpanTextWidth)) {
+      drawProfiler();
+      ImGui::TreePop();
+    }
+
+#ifdef ENABLE_TRACING
+    bool recording = Core::Trace::isRecording();
+    if (ImGui::Checkbox("Record Trace", &recording)) {
+      if (recording) {
+        Core::Trace::start(Core::Trace::getPath());
+      } else if (!Core::Trace::stop()) {
+        warn("Failed to write the trace");
+      }
+    }
+    ImGui::SetItemTooltip("Timeline of all threads written to %s, open it in ui.perfetto.dev", Core::Trace::getPath().c_str());
+#endif
+
     ImGui::End(); // Controls
   }
 
+  static float sum(const float* values, int n) { return std::accumulate(values, values + n, 0.0f); }
+
+  static float toMiB(size_t bytes) { return float(bytes) / (1024.0f * 1024.0f); }
+
+  void SweApp::drawProfiler() {
+    using Core::ProfileCounter;
+    using Core::ProfileScope;
+    using Core::Profiler;
+
+    float values[Profiler::HistorySize];
+    float solverTime = 0.0f; // Milliseconds over the history
+
+    for (int s = 0; s < (int)ProfileScope::Count; s++) {
+      ProfileScope scope = (ProfileScope)s;
+      int          n     = Profiler::getHistory(scope, values, Profiler::HistorySize);
+      float        total = sum(values, n);
+      if (scope == ProfileScope::GhostLayer || scope == ProfileScope::XSweep || scope == ProfileScope::YSweep || scope == ProfileScope::BlockedSteps || scope == ProfileScope::MaxTimeStep) {
+        solverTime += total;
+      }
+
+      char overlay[32];
+      std::snprintf(overlay, sizeof(overlay), "%.2f ms", n > 0 ? total / n : 0.0f);
+      ImGui::PlotLines(Profiler::getName(scope), values, n, 0, overlay, 0.0f, FLT_MAX, ImVec2(0.0f, 30.0f));
+    }
+
+    int   n         = Profiler::getFrameTimes(values, Profiler::HistorySize);
+    float wallTime  = sum(values, n);
+    n               = Profiler::getHistory(ProfileCounter::Cells, values, Profiler::HistorySize);
+    float cells     = sum(values, n);
+    n               = Profiler::getHistory(ProfileCounter::SimulatedTime, values, Profiler::HistorySize);
+    float simulated = sum(values, n);
+
+    ImGui::TextDisabled("Cells/s: %.3g", solverTime > 0.0f ? cells / (solverTime * 0.001f) : 0.0f);
+    ImGui::SetItemTooltip("Updated cells per second of solver time (ghost layer, sweeps and time step)");
+    ImGui::TextDisabled("Sim s / wall s: %.3g", wallTime > 0.0f ? simulated / (wallTime * 0.001f) : 0.0f);
+
+    if (ImGui::Checkbox("Hardware Counters", &m_perfCounters)) {
+      // Counters count the thread that opens them and the parallelFor threads, the sweeps run on the solver thread
+      m_solverWorker.start([enable = m_perfCounters] {
+        if (enable) {
+          Core::PerfCounters::start();
+        } else {
+          Core::PerfCounters::stop();
+        }
+      });
+      m_solverWorker.wait();
+      m_perfSweeps[0] = m_perfSweeps[1] = {};
+    }
+    ImGui::SetItemTooltip("Cycles, instructions and cache misses of the sweeps, summed over all solver threads (Linux perf events)");
+
+    if (m_perfCounters) {
+      // Show the counts of the last full second
+      double time = ImGui::GetTime();
+      if (time - m_perfSnapshotTime >= 1.0) {
+        m_perfSweeps[0]    = Core::PerfCounters::getTotals(ProfileScope::XSweep);
+        m_perfSweeps[1]    = Core::PerfCounters::getTotals(ProfileScope::YSweep);
+        m_perfSnapshotTime = time;
+        Core::PerfCounters::reset();
+      }
+
+      if (!Core::PerfCounters::isAvailable(Core::PerfEvent::Cycles)) {
+        ImGui::TextDisabled("%s", Core::PerfCounters::getError().c_str());
+      } else {
+        // The y-sweep runs once per step, the x-sweep is counted in two parts. Cycles are summed over all threads.
+        double cellSteps = double(m_dimensions.x) * m_dimensions.y * m_perfSweeps[1].calls;
+        for (int s = 0; s < 2; s++) {
+          const Core::PerfTotals& totals = m_perfSweeps[s];
+          double                  cycles = double(totals.counts[(int)Core::PerfEvent::Cycles]);
+          ImGui::TextDisabled(
+            "%s: IPC %.2f, %.2f GB/s, %.1f cycles/cell",
+            Profiler::getName(s == 0 ? ProfileScope::XSweep : ProfileScope::YSweep),
+            totals.getIpc(),
+            totals.getBytesPerSecond() * 1e-9,
+            cellSteps > 0.0 ? cycles / cellSteps : 0.0
+          );
+          if (Core::PerfCounters::isAvailable(Core::PerfEvent::VectorInstructions)) {
+            ImGui::SameLine();
+            ImGui::TextDisabled(", %.0f%% vector", totals.getVectorFraction() * 100.0);
+          }
+        }
+      }
+    }
+
+    if (!isBlockLoaded()) {
+      return;
+    }
+
+    // Memory footprint of the current grid per subsystem
+    size_t cellCount   = size_t(m_dimensions.x) * m_dimensions.y;
+    size_t texelSize   = getHeightMapTexelSize(m_heightMapFormat);
+    size_t indexMemory = m_indices ? m_indexCount * sizeof(uint32_t) : 0;
+    size_t solver      = m_block->getMemoryUsage();
+    size_t renderCpu   = cellCount + cellCount * texelSize + indexMemory;     // Dry mask, height map texels and indices
+    size_t renderGpu   = cellCount + 2 * cellCount * texelSize + indexMemory; // Dry mask, height map and bathymetry, indices
+
+    ImGui::TextDisabled("Memory: solver %.1f MiB, render %.1f MiB (GPU %.1f MiB)", toMiB(solver), toMiB(renderCpu), toMiB(renderGpu));
+  }
+
   void SweApp::drawScenarioSelectionWindow() {
     ImGui::Begin("Scenario Selection", &m_showScenarioSelection, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse);
 
@@ -764,11 +1333,37 @@ namespace App {
       ImGui::EndCombo();
     }
 
-    if (ImGui::InputInt2("Grid Dimensions", m_selectedDimensions)) {
-      m_selectedDimensions.x = std::clamp(m_selectedDimensions.x, 2, 2000);
-      m_selectedDimensions.y = std::clamp(m_selectedDimensions.y, 2, 2000);
+    // Level of detail draws larger grids, up to the texture size (the selection shrinks if it is turned off)
+    int maxDimension = m_terrainLod ? std::max(MaxFullGridDimension, (int)bgfx::getCaps()->limits.maxTextureSize) : MaxFullGridDimension;
+    ImGui::InputInt2("Grid Dimensions", m_selectedDimensions);
+    m_selectedDimensions.x = std::clamp(m_selectedDimensions.x, 2, maxDimension);
+    m_selectedDimensions.y = std::clamp(m_selectedDimensions.y, 2, maxDimension);
+    ImGui::SetItemTooltip("Up to %d cells per axis%s", maxDimension, m_terrainLod ? "" : ", more with level of detail");
+
+    if (m_selectedScenarioType == ScenarioType::Tohoku || m_selectedScenarioType == ScenarioType::TohokuZoomed || m_selectedScenarioType == ScenarioType::Chile) {
+      const char* resampleModeNames[] = {"Nearest", "Bilinear", "Area"};
+      if (ImGui::BeginCombo("Resampling", resampleModeNames[(int)m_resampleMode])) {
+        for (int i = 0; i < 3; i++) {
+          if (ImGui::Selectable(resampleModeNames[i], (int)m_resampleMode == i)) {
+            m_resampleMode = (Scenarios::ResampleMode)i;
+          }
+        }
+        ImGui::EndCombo();
+      }
+      ImGui::SetItemTooltip("Filter used to sample the data onto the grid (cached on disk)");
     }
 
+    if (ImGui::BeginCombo("Bathymetry Storage", compactFormatToString(m_bathymetryFormat).c_str())) {
+      for (int i = 0; i < (int)CompactFormat::Count; i++) {
+        CompactFormat format = (CompactFormat)i;
+        if (ImGui::Selectable(compactFormatToString(format).c_str(), m_bathymetryFormat == format)) {
+          m_bathymetryFormat = format;
+        }
+      }
+      ImGui::EndCombo();
+    }
+    ImGui::SetItemTooltip("Bits per cell of the bathymetry read by the solver, rounded bathymetry with the same sea surface");
+
 #ifdef ENABLE_NETCDF
     if (m_selectedScenarioType == ScenarioType::NetCDF) {
       ImGui::Text("Drag-drop GEBCO netCDF files generated from ");
@@ -786,7 +1381,15 @@ namespace App {
     }
 #endif
 
-    if (ImGui::Button("Load Scenario")) {
+    if (m_loadJob) {
+      bool cancelled = m_loadJob->progress.isCancelled();
+      ImGui::ProgressBar(m_loadJob->progress.getFraction(), ImVec2(-1.0f, 0.0f), cancelled ? "Cancelling..." : nullptr);
+      ImGui::BeginDisabled(cancelled);
+      if (ImGui::Button("Cancel")) {
+        cancelLoadJob();
+      }
+      ImGui::EndDisabled();
+    } else if (ImGui::Button("Load Scenario")) {
       selectScenario();
     }
 
@@ -1006,15 +1609,26 @@ namespace App {
 
   void SweApp::tryAutoLoadNcFiles([[maybe_unused]] Vec2i dimensions, [[maybe_unused]] bool silent) {
 #ifdef ENABLE_NETCDF
+    if (m_loadJob) {
+      // Only one scenario is loaded at a time, the files of the last drop are loaded afterwards
+      m_pendingNcLoad = PendingNcLoad{m_bathymetryFile, m_displacementFile, dimensions, silent};
+      warn("Still loading a scenario, the dropped files are loaded next");
+      return;
+    }
+
     auto typeBackup        = m_selectedScenarioType;
     auto dimensionsBackup  = m_selectedDimensions;
     m_selectedScenarioType = ScenarioType::NetCDF;
     m_selectedDimensions   = dimensions;
-    if (!selectScenario(silent)) {
+
+    auto restoreSelection = [this, typeBackup, dimensionsBackup]() {
       m_bathymetryFile[0]    = '\0';
       m_displacementFile[0]  = '\0';
       m_selectedScenarioType = typeBackup;
       m_selectedDimensions   = dimensionsBackup;
+    };
+    if (!selectScenario(silent, restoreSelection)) {
+      restoreSelection();
     }
 #endif
   }
@@ -1037,10 +1651,29 @@ namespace App {
     return false;
   }
 
-  bgfx::VertexLayout CellVertex::layout;
+} // namespace App
 
-  void CellVertex::init() { layout.begin().add(bgfx::Attrib::Position, 1, bgfx::AttribType::Uint8, true).end(); };
+Core::Application* Core::createApplication(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+#ifdef ENABLE_TRACING
+    if (arg == "--trace") {
+      bool hasPath = i + 1 < argc && argv[i + 1][0] != '-';
+      Core::Trace::start(hasPath ? argv[++i] : Core::Trace::DefaultPath);
+      continue;
+    }
+#endif
+    if (arg == "--isa" && i + 1 < argc) {
+      Core::Isa isa = Core::Isa::Generic;
+      if (!Core::parseIsa(argv[++i], isa) || !Core::setIsa(isa)) {
+        std::cerr << "Instruction set " << argv[i] << " is not available" << std::endl;
+      }
+      continue;
+    }
+    std::cerr << "Unknown argument " << arg << std::endl;
+  }
 
-} // namespace App
+  std::cout << "Kernels: " << Core::getIsaName(Core::getIsa()) << " (best supported: " << Core::getIsaName(Core::getBestIsa()) << ")" << std::endl;
 
-Core::Application* Core::createApplication(int, char**) { return new App::SweApp(); }
+  return new App::SweApp();
+}
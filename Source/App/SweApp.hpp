@@ -1,16 +1,57 @@
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "Blocks/DimensionalSplitting.hpp"
 #include "Camera.hpp"
 #include "Core/Application.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/PerfCounters.hpp"
+#include "Core/Progress.hpp"
+#include "Scenarios/Resampler.hpp"
+#include "Terrain.hpp"
+#include "Types/HeightMapFormat.hpp"
 #include "Types/ScenarioType.hpp"
 #include "Types/ViewType.hpp"
 
 namespace App {
 
-  struct CellVertex {
-    uint8_t isDry = 0;
-
-    static bgfx::VertexLayout layout;
-    static void               init();
+  /**
+   * Scenario construction and block initialisation running in the background.
+   *
+   * The job works on copies of the selection, so the current block can keep running and rendering.
+   * The results are owned by the job until they are swapped into the app on the main thread.
+   */
+  struct LoadJob {
+    ScenarioType            scenarioType;
+    Vec2i                   dimensions;
+    BoundaryType            boundaryType;
+    Scenarios::ResampleMode resampleMode;
+    CompactFormat           bathymetryFormat;
+    std::string             bathymetryFile;
+    std::string             displacementFile;
+    bool                    silent       = false;
+    bool                    buildIndices = true; // Index buffer of the full grid, not needed for level of detail rendering
+
+    std::function<void()> onFailure; // Called on the main thread if loading failed (not if cancelled)
+
+    Core::Progress    progress; // Cancelled to stop the job early, reading and sampling check it per row
+    std::atomic<bool> finished = false;
+
+    bool                 success    = false;
+    Scenarios::Scenario* scenario   = nullptr;
+    Blocks::Block*       block      = nullptr;
+    uint8_t*             dryMask    = nullptr;
+    uint32_t*            indices    = nullptr;
+    int                  indexCount = 0;
+
+    std::thread thread;
+
+    ~LoadJob();
   };
 
   class SweApp: public Core::Application {
@@ -31,11 +72,17 @@ namespace App {
     bool isBlockLoaded();
     void destroyBlock();
     void destroyProgram();
-    bool loadScenario();
     void setNoneScenario();
-    bool initializeBlock(bool silent);
-    void createGrid(Vec2i n);
-    bool selectScenario(bool silentHint = false);
+    void swapInLoadJob();
+    void createGrid(Vec2i n, int indexCount);
+    void createHeightMap();
+    void destroyHeightMap();
+    void setHeightMapFormat(HeightMapFormat format);
+    void setTerrainLod(bool enabled);
+    bool selectScenario(bool silentHint = false, std::function<void()> onFailure = nullptr);
+    void startLoadJob();
+    void cancelLoadJob();
+    void finishLoadJob();
     void startStopSimulation();
     void resetSimulation();
     void setWetDataRange();
@@ -55,6 +102,7 @@ namespace App {
     bool addBathDisplFile(std::string_view path, int select = 0);
 
     void simulate(float dt);
+    void finishSimulation();
     void updateGrid();
     void updateControls(float dt);
     void updateCamera();
@@ -63,12 +111,19 @@ namespace App {
     void drawControlWindow(float dt);
     void drawScenarioSelectionWindow();
     void drawHelpWindow();
+    void drawProfiler();
+
+    static void                     runLoadJob(LoadJob& job);
+    static Scenarios::Scenario*     createScenario(LoadJob& job);
+    static bool                     buildGrid(LoadJob& job);
+    static uint32_t*                buildGridIndices(Vec2i n, int& indexCount);
+    static std::vector<std::string> getAssetFiles(ScenarioType scenarioType); // Data files that are downloaded on demand in the web build
 
   private:
     bgfx::ProgramHandle m_program;
+    bgfx::ProgramHandle m_terrainProgram;
 
-    bgfx::VertexBufferHandle m_vbh;
-    bgfx::IndexBufferHandle  m_ibh;
+    bgfx::IndexBufferHandle m_ibh = BGFX_INVALID_HANDLE;
 
     bgfx::UniformHandle u_gridData;
     bgfx::UniformHandle u_boundaryPos;
@@ -79,12 +134,35 @@ namespace App {
     bgfx::UniformHandle u_color2;
     bgfx::UniformHandle u_color3;
 
+    bgfx::UniformHandle u_heightMapRange;
+    bgfx::UniformHandle u_viewComposition;
     bgfx::UniformHandle s_heightMap;
     bgfx::TextureHandle m_heightMap;
+    bgfx::UniformHandle s_dryMask;
+    bgfx::TextureHandle m_dryMask = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_bathymetry;
+    bgfx::TextureHandle m_bathymetry;
+
+    Terrain m_terrain;
+    bool    m_terrainLodSupported = false;
+    bool    m_terrainLod          = true; // Draw level of detail patches instead of the full grid
+    float   m_terrainDetail       = 2.0f; // Screen size in pixels up to which patch quads are not split
+
+    uint8_t*  m_dryMaskData   = nullptr; // 255 for dry cells
+    uint32_t* m_indices       = nullptr; // Only allocated without level of detail rendering
+    int       m_indexCount    = 0;
+    uint8_t*  m_heightMapData = nullptr; // Texels of the last upload of the streamed view, encoded in m_heightMapFormat
 
-    CellVertex* m_vertices      = nullptr;
-    uint32_t*   m_indices       = nullptr;
-    float*      m_heightMapData = nullptr;
+    HeightMapFormat m_heightMapFormat = HeightMapFormat::R32F;
+    Vec4f           m_heightMapRange  = {0.0f, 1.0f, 0.0f, 1.0f}; // x: offset, y: scale of normalized texels, z, w: same for the bathymetry
+
+    bool             m_perfCounters     = false;
+    Core::PerfTotals m_perfSweeps[2]    = {}; // Counts of the x- and y-sweep over the last second
+    double           m_perfSnapshotTime = 0.0;
+
+    bool m_gridDirty       = false; // Block values changed since the last upload to the height map
+    bool m_viewRangesDirty = false; // Recompute the value ranges of the view on the next upload (always done with autoscale)
+    bool m_uploadAll       = false; // Texture content is undefined, upload the whole height map
 
     Vec4f m_gridData;    // x: nx, y: ny, z: dx, w: dy
     Vec4f m_boundaryPos; // x: left, y: right, z: bottom, w: top
@@ -105,13 +183,26 @@ namespace App {
     ScenarioType m_scenarioType = ScenarioType::None;
     Vec2i        m_dimensions;
 
-    ViewType     m_viewType     = ViewType::HPlusB;
-    BoundaryType m_boundaryType = BoundaryType::Outflow;
+    std::unique_ptr<LoadJob> m_loadJob;
+
+    ViewType                m_viewType         = ViewType::HPlusB;
+    BoundaryType            m_boundaryType     = BoundaryType::Outflow;
+    Scenarios::ResampleMode m_resampleMode     = Scenarios::ResampleMode::Nearest;
+    CompactFormat           m_bathymetryFormat = CompactFormat::Full; // Storage of the bathymetry read by the sweeps
     float        m_timeScale    = 60.0f;
 
 #ifdef ENABLE_NETCDF
     char m_bathymetryFile[128]   = {};
     char m_displacementFile[128] = {};
+
+    // Files dropped while a scenario was loading, loaded when the load job finished
+    struct PendingNcLoad {
+      std::string bathymetryFile;
+      std::string displacementFile;
+      Vec2i       dimensions;
+      bool        silent;
+    };
+    std::optional<PendingNcLoad> m_pendingNcLoad;
 #endif
 
     bool  m_customDisplacement   = false;
@@ -122,6 +213,12 @@ namespace App {
     bool  m_playing        = false;
     float m_simulationTime = 0.0;
 
+    Core::Worker m_solverWorker{"Solver"}; // Steps the block while the main thread renders
+    bool         m_stepRunning   = false;
+    RealType     m_stepTime      = 0.0; // Time step of the running step, written by the solver thread
+    int          m_stepsPerFrame = 1;   // Steps of the same size per frame, computed in one pass over the grid
+    int          m_stepCount     = 0;   // Steps of the running pass
+
     Camera m_camera{m_windowSize, m_boundaryPos, m_cameraClipping};
 
     uint64_t m_stateFlags = BGFX_STATE_WRITE_MASK | BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_PT_LINES;
@@ -0,0 +1,194 @@
+#include "Terrain.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Utils.hpp"
+
+namespace App {
+
+  bgfx::VertexLayout PatchVertex::layout;
+
+  void PatchVertex::init() { layout.begin().add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float).end(); }
+
+  void Terrain::create() {
+    PatchVertex::init();
+
+    constexpr int N = PatchSize + 1;
+
+    const bgfx::Memory* vertexMemory = bgfx::alloc(N * N * sizeof(PatchVertex));
+    PatchVertex*        vertices     = reinterpret_cast<PatchVertex*>(vertexMemory->data);
+    for (int j = 0; j < N; j++) {
+      for (int i = 0; i < N; i++) {
+        vertices[j * N + i] = {(float)i, (float)j};
+      }
+    }
+
+    const bgfx::Memory* indexMemory = bgfx::alloc(6 * PatchSize * PatchSize * sizeof(uint16_t));
+    uint16_t*           indices     = reinterpret_cast<uint16_t*>(indexMemory->data);
+    int                 index       = 0;
+    for (int j = 0; j < PatchSize; j++) {
+      for (int i = 0; i < PatchSize; i++) {
+        uint16_t topLeft     = uint16_t(j * N + i);
+        uint16_t topRight    = topLeft + 1;
+        uint16_t bottomLeft  = uint16_t((j + 1) * N + i);
+        uint16_t bottomRight = bottomLeft + 1;
+        indices[index++]     = topLeft;
+        indices[index++]     = bottomLeft;
+        indices[index++]     = topRight;
+        indices[index++]     = topRight;
+        indices[index++]     = bottomLeft;
+        indices[index++]     = bottomRight;
+      }
+    }
+
+    m_vbh = bgfx::createVertexBuffer(vertexMemory, PatchVertex::layout);
+    m_ibh = bgfx::createIndexBuffer(indexMemory);
+  }
+
+  void Terrain::destroy() {
+    if (bgfx::isValid(m_vbh)) {
+      bgfx::destroy(m_vbh);
+      bgfx::destroy(m_ibh);
+    }
+    m_vbh = BGFX_INVALID_HANDLE;
+    m_ibh = BGFX_INVALID_HANDLE;
+  }
+
+  // True if the box is completely outside of one of the side or near planes
+  static bool isOutsideFrustum(const float* viewProjection, const bx::Vec3& lower, const bx::Vec3& upper) {
+    float nearW      = bgfx::getCaps()->homogeneousDepth ? -1.0f : 0.0f;
+    int   outside[5] = {};
+
+    for (int c = 0; c < 8; c++) {
+      bx::Vec3 p    = {c & 1 ? upper.x : lower.x, c & 2 ? upper.y : lower.y, c & 4 ? upper.z : lower.z};
+      bx::Vec3 clip = bx::mul(p, viewProjection);
+      float    w    = p.x * viewProjection[3] + p.y * viewProjection[7] + p.z * viewProjection[11] + viewProjection[15];
+
+      outside[0] += clip.x < -w;
+      outside[1] += clip.x > w;
+      outside[2] += clip.y < -w;
+      outside[3] += clip.y > w;
+      outside[4] += clip.z < nearW * w;
+    }
+
+    return std::find(std::begin(outside), std::end(outside), 8) != std::end(outside);
+  }
+
+  void Terrain::select(const Camera& camera, Vec2i n, Vec2f origin, Vec2f cellSize, Vec2f zRange, float pixelsPerQuad) {
+    m_patches.clear();
+    m_nodes.clear();
+
+    m_camera        = &camera;
+    m_quads         = {n.x - 1, n.y - 1};
+    m_origin        = origin;
+    m_cellSize      = cellSize;
+    m_zRange        = zRange;
+    m_pixelsPerQuad = pixelsPerQuad;
+
+    if (m_quads.x < 1 || m_quads.y < 1) {
+      return;
+    }
+
+    m_rootStep = 1;
+    while (PatchSize * m_rootStep < std::max(m_quads.x, m_quads.y)) {
+      m_rootStep *= 2;
+    }
+
+    m_nodes.emplace_back();
+    refine(0, 0, 0, m_rootStep);
+
+    // Find the coarser neighbours (a coarser neighbour always covers the whole edge)
+    for (Patch& patch : m_patches) {
+      int x0   = (int)patch.x;
+      int y0   = (int)patch.y;
+      int step = (int)patch.step;
+      int size = PatchSize * step;
+
+      int neighbours[4] = {
+        x0 > 0 ? getStep(x0 - 1, y0) : step,
+        x0 + size < m_quads.x ? getStep(x0 + size, y0) : step,
+        y0 > 0 ? getStep(x0, y0 - 1) : step,
+        y0 + size < m_quads.y ? getStep(x0, y0 + size) : step,
+      };
+      for (int e = 0; e < 4; e++) {
+        patch.stitch[e] = (float)std::clamp(neighbours[e] / step, 1, PatchSize);
+      }
+    }
+  }
+
+  void Terrain::refine(int node, int x0, int y0, int step) {
+    if (x0 >= m_quads.x || y0 >= m_quads.y) {
+      return; // Outside of the grid
+    }
+
+    int size = PatchSize * step;
+
+    // Vertices are placed at the cell centers
+    bx::Vec3 lower = {m_origin.x + (x0 + 0.5f) * m_cellSize.x, m_origin.y + (y0 + 0.5f) * m_cellSize.y, m_zRange.x};
+    bx::Vec3 upper = {
+      m_origin.x + (std::min(x0 + size, m_quads.x) + 0.5f) * m_cellSize.x,
+      m_origin.y + (std::min(y0 + size, m_quads.y) + 0.5f) * m_cellSize.y,
+      m_zRange.y,
+    };
+
+    if (isOutsideFrustum(m_camera->getViewProjection(), lower, upper)) {
+      return;
+    }
+
+    bx::Vec3 eye      = toBxVec3(m_camera->getEye());
+    float    distance = bx::length(bx::sub(eye, bx::min(bx::max(eye, lower), upper)));
+    float    quadSize = step * std::max(m_cellSize.x, m_cellSize.y);
+
+    if (step > 1 && m_camera->getPixelsPerUnit(distance) * quadSize > m_pixelsPerQuad) {
+      int child           = (int)m_nodes.size();
+      int half            = size / 2;
+      m_nodes[node].child = child;
+      m_nodes.resize(m_nodes.size() + 4);
+
+      refine(child + 0, x0, y0, step / 2);
+      refine(child + 1, x0 + half, y0, step / 2);
+      refine(child + 2, x0, y0 + half, step / 2);
+      refine(child + 3, x0 + half, y0 + half, step / 2);
+      return;
+    }
+
+    m_patches.push_back({(float)x0, (float)y0, (float)step, 0.0f, {1.0f, 1.0f, 1.0f, 1.0f}});
+  }
+
+  int Terrain::getStep(int x, int y) const {
+    int node = 0;
+    int x0   = 0;
+    int y0   = 0;
+    int step = m_rootStep;
+
+    while (m_nodes[node].child >= 0) {
+      int half  = PatchSize * step / 2;
+      int right = x >= x0 + half;
+      int upper = y >= y0 + half;
+      node      = m_nodes[node].child + right + 2 * upper;
+      x0 += right * half;
+      y0 += upper * half;
+      step /= 2;
+    }
+
+    return step;
+  }
+
+  bool Terrain::setBuffers() const {
+    uint32_t count = std::min((uint32_t)m_patches.size(), bgfx::getAvailInstanceDataBuffer((uint32_t)m_patches.size(), sizeof(Patch)));
+    if (count == 0) {
+      return false;
+    }
+
+    bgfx::InstanceDataBuffer idb;
+    bgfx::allocInstanceDataBuffer(&idb, count, sizeof(Patch));
+    std::memcpy(idb.data, m_patches.data(), count * sizeof(Patch));
+
+    bgfx::setVertexBuffer(0, m_vbh);
+    bgfx::setIndexBuffer(m_ibh);
+    bgfx::setInstanceDataBuffer(&idb);
+    return true;
+  }
+
+} // namespace App
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+#include <vector>
+
+#include "Camera.hpp"
+#include "Types/Vec.hpp"
+
+namespace App {
+
+  struct PatchVertex {
+    float x, y; // Position in the patch lattice, 0 to Terrain::PatchSize
+
+    static bgfx::VertexLayout layout;
+    static void               init();
+  };
+
+  /**
+   * Level of detail rendering of the grid with a single, instanced patch mesh.
+   *
+   * The grid is covered by a quadtree of square patches with PatchSize x PatchSize quads. A patch with
+   * step s spans PatchSize * s cells and places a vertex on every s-th cell. Patches are split until one
+   * of their quads covers at most the requested number of pixels and patches outside of the view frustum
+   * are skipped, so the drawn vertices depend on the screen resolution instead of the grid resolution.
+   *
+   * Vertices on an edge to a coarser patch are snapped onto the vertices of that patch to avoid cracks.
+   */
+  class Terrain {
+  public:
+    static constexpr int PatchSize = 32; // Has to match vs_swe_terrain.sc
+
+    void create();
+    void destroy();
+
+    /**
+     * Selects the patches for the current camera.
+     *
+     * @param n             Number of grid vertices (cells) in x and y.
+     * @param origin        World position of the lower left grid corner.
+     * @param cellSize      World size of a cell.
+     * @param zRange        Lower and upper bound of the (scaled) vertex heights, used for culling.
+     * @param pixelsPerQuad Screen size up to which a quad is not split further.
+     */
+    void select(const Camera& camera, Vec2i n, Vec2f origin, Vec2f cellSize, Vec2f zRange, float pixelsPerQuad);
+
+    /// Sets the buffers for drawing the selected patches, returns false if there is nothing to draw
+    bool setBuffers() const;
+
+    int getPatchCount() const { return (int)m_patches.size(); }
+
+  private:
+    struct Patch {
+      float x, y;      // First cell
+      float step;      // Cells per quad
+      float unused;
+      float stitch[4]; // Step ratio to a coarser neighbour (left, right, bottom, top), 1 if none
+    };
+
+    struct Node {
+      int child = -1; // Index of the first of four children (lower left, lower right, upper left, upper right), -1 for leaves
+    };
+
+    void refine(int node, int x0, int y0, int step);
+    int  getStep(int x, int y) const;
+
+  private:
+    bgfx::VertexBufferHandle m_vbh = BGFX_INVALID_HANDLE;
+    bgfx::IndexBufferHandle  m_ibh = BGFX_INVALID_HANDLE;
+
+    std::vector<Patch> m_patches;
+    std::vector<Node>  m_nodes;
+
+    // Parameters of the current selection
+    const Camera* m_camera = nullptr;
+    Vec2i         m_quads;
+    Vec2f         m_origin;
+    Vec2f         m_cellSize;
+    Vec2f         m_zRange;
+    float         m_pixelsPerQuad = 1.0f;
+    int           m_rootStep      = 1;
+  };
+
+} // namespace App
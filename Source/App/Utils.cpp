@@ -1,9 +1,16 @@
 #include "Utils.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cfloat>
 #include <cmath>
 #include <filesystem>
 #include <imgui.h>
+#include <mutex>
+#include <vector>
+
+#include "Core/Isa.hpp"
+#include "Core/Parallel.hpp"
 
 namespace App {
 
@@ -63,6 +70,51 @@ namespace App {
     return {};
   }
 
+  std::string heightMapFormatToString(HeightMapFormat format) {
+    switch (format) {
+    case HeightMapFormat::R32F:
+      return "32 bit float";
+    case HeightMapFormat::R16F:
+      return "16 bit float";
+    case HeightMapFormat::R16:
+      return "16 bit normalized";
+    case HeightMapFormat::R8:
+      return "8 bit normalized";
+    default:
+      assert(false);
+    }
+    return {};
+  }
+
+  std::string compactFormatToString(CompactFormat format) {
+    switch (format) {
+    case CompactFormat::Full:
+      return "Full precision";
+    case CompactFormat::Half:
+      return "16 bit float";
+    case CompactFormat::BFloat16:
+      return "bfloat16";
+    default:
+      assert(false);
+    }
+    return {};
+  }
+
+  int getHeightMapTexelSize(HeightMapFormat format) {
+    switch (format) {
+    case HeightMapFormat::R32F:
+      return 4;
+    case HeightMapFormat::R16F:
+    case HeightMapFormat::R16:
+      return 2;
+    case HeightMapFormat::R8:
+      return 1;
+    default:
+      assert(false);
+    }
+    return 0;
+  }
+
   uint32_t colorToInt(float* color4) {
     uint32_t color = 0;
     for (int i = 0; i < 4; i++) {
@@ -116,6 +168,274 @@ namespace App {
     return getBlockValue(block, type, i, j);
   }
 
+  /// Min/max of the wet and dry values of a row, accumulated into minMaxWet and minMaxDry
+  SWE_FORCE_INLINE static void reduceMinMax(const float* values, const uint8_t* isDry, int n, Vec2f& minMaxWet, Vec2f& minMaxDry) {
+    // Independent lanes let the compiler map the reduction onto SIMD min/max instructions
+    constexpr int Lanes = 8;
+
+    float wetMin[Lanes], wetMax[Lanes], dryMin[Lanes], dryMax[Lanes];
+    std::fill_n(wetMin, Lanes, minMaxWet.x);
+    std::fill_n(wetMax, Lanes, minMaxWet.y);
+    std::fill_n(dryMin, Lanes, minMaxDry.x);
+    std::fill_n(dryMax, Lanes, minMaxDry.y);
+
+    // Masked reduction: values of the other kind are replaced by the neutral element
+    int i = 0;
+    for (; i + Lanes <= n; i += Lanes) {
+      for (int l = 0; l < Lanes; l++) {
+        float value   = values[i + l];
+        bool  wet     = isDry[i + l] == 0;
+        float wetLow  = wet ? value : FLT_MAX;
+        float wetHigh = wet ? value : -FLT_MAX;
+        float dryLow  = wet ? FLT_MAX : value;
+        float dryHigh = wet ? -FLT_MAX : value;
+        wetMin[l]     = std::min(wetMin[l], wetLow);
+        wetMax[l]     = std::max(wetMax[l], wetHigh);
+        dryMin[l]     = std::min(dryMin[l], dryLow);
+        dryMax[l]     = std::max(dryMax[l], dryHigh);
+      }
+    }
+    for (; i < n; i++) {
+      float value   = values[i];
+      bool  wet     = isDry[i] == 0;
+      float wetLow  = wet ? value : FLT_MAX;
+      float wetHigh = wet ? value : -FLT_MAX;
+      float dryLow  = wet ? FLT_MAX : value;
+      float dryHigh = wet ? -FLT_MAX : value;
+      wetMin[0]     = std::min(wetMin[0], wetLow);
+      wetMax[0]     = std::max(wetMax[0], wetHigh);
+      dryMin[0]     = std::min(dryMin[0], dryLow);
+      dryMax[0]     = std::max(dryMax[0], dryHigh);
+    }
+
+    for (int l = 0; l < Lanes; l++) {
+      minMaxWet.x = std::min(minMaxWet.x, wetMin[l]);
+      minMaxWet.y = std::max(minMaxWet.y, wetMax[l]);
+      minMaxDry.x = std::min(minMaxDry.x, dryMin[l]);
+      minMaxDry.y = std::max(minMaxDry.y, dryMax[l]);
+    }
+  }
+
+  /// Composes a row of a view (values + added if not nullptr) into row and accumulates its min/max, see reduceMinMax
+  SWE_FORCE_INLINE static void reduceViewRow(const RealType* values, const RealType* added, const uint8_t* isDry, int n, float* row, Vec2f& minMaxWet, Vec2f& minMaxDry) {
+    if (added) {
+      for (int i = 0; i < n; i++) {
+        row[i] = float(values[i] + added[i]);
+      }
+    } else {
+      for (int i = 0; i < n; i++) {
+        row[i] = float(values[i]);
+      }
+    }
+
+    reduceMinMax(row, isDry, n, minMaxWet, minMaxDry);
+  }
+
+  SWE_ISA_VARIANTS(void, reduceViewRow)
+
+  ViewType getStreamedView(ViewType type, HeightMapFormat format) {
+    switch (type) {
+    case ViewType::H:
+      return ViewType::H;
+    case ViewType::HPlusB:
+      return format == HeightMapFormat::R32F ? ViewType::H : ViewType::HPlusB;
+    case ViewType::Hu:
+    case ViewType::Hv:
+      return type;
+    case ViewType::B:
+      return ViewType::Count;
+    default:
+      assert(false);
+    }
+    return ViewType::Count;
+  }
+
+  Vec4f getViewComposition(ViewType type, HeightMapFormat format) {
+    switch (type) {
+    case ViewType::H:
+    case ViewType::Hu:
+    case ViewType::Hv:
+      return {1.0f, 0.0f, 0.0f, 0.0f};
+    case ViewType::B:
+      return {0.0f, 1.0f, 1.0f, 0.0f};
+    case ViewType::HPlusB:
+      // The streamed surface of the wet cells already holds b
+      return format == HeightMapFormat::R32F ? Vec4f{1.0f, 1.0f, 1.0f, 0.0f} : Vec4f{1.0f, 0.0f, 1.0f, 0.0f};
+    default:
+      assert(false);
+    }
+    return {};
+  }
+
+  const Float2D<RealType>& getBlockValues(const Blocks::Block* block, ViewType type) {
+    switch (type) {
+    case ViewType::H:
+      return block->getWaterHeight();
+    case ViewType::Hu:
+      return block->getDischargeHu();
+    case ViewType::Hv:
+      return block->getDischargeHv();
+    case ViewType::B:
+      return block->getBathymetry();
+    default:
+      assert(false);
+    }
+    return block->getWaterHeight(); // dummy
+  }
+
+  void computeViewRanges(const Blocks::Block* block, ViewType type, const uint8_t* isDry, Vec2f& minMaxWet, Vec2f& minMaxDry) {
+    int nx = block->getNx();
+    int ny = block->getNy();
+
+    // Value is first[j][i] (+ second[j][i])
+    const Float2D<RealType>* first  = type == ViewType::HPlusB ? &block->getWaterHeight() : &getBlockValues(block, type);
+    const Float2D<RealType>* second = type == ViewType::HPlusB ? &block->getBathymetry() : nullptr;
+
+    minMaxWet = {FLT_MAX, -FLT_MAX};
+    minMaxDry = {FLT_MAX, -FLT_MAX};
+
+    std::mutex mutex;
+
+    // Chunks of at least 64k cells, so small grids don't pay for threads
+    Core::parallelFor(
+      0,
+      ny,
+      [&](int jBegin, int jEnd) {
+        std::vector<float> row(nx); // Composed values of a row, stays in cache
+        Vec2f              wet       = {FLT_MAX, -FLT_MAX};
+        Vec2f              dryMinMax = {FLT_MAX, -FLT_MAX};
+
+        for (int j = jBegin; j < jEnd; j++) {
+          const RealType* src = (*first)[j + 1] + 1;
+          const RealType* add = second ? (*second)[j + 1] + 1 : nullptr;
+          SWE_ISA_CALL(reduceViewRow, src, add, isDry + j * nx, nx, row.data(), wet, dryMinMax);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        minMaxWet.x = std::min(minMaxWet.x, wet.x);
+        minMaxWet.y = std::max(minMaxWet.y, wet.y);
+        minMaxDry.x = std::min(minMaxDry.x, dryMinMax.x);
+        minMaxDry.y = std::max(minMaxDry.y, dryMinMax.y);
+      },
+      std::max(1, 65536 / nx)
+    );
+  }
+
+  /// Encodes a row (+ wetAdded for wet cells if not nullptr) into scratch and copies the changed span into texels, returns the span (x > y if unchanged)
+  template <class Texel, class Encode>
+  SWE_FORCE_INLINE static Vec2i encodeHeightMapRow(const RealType* values, const RealType* wetAdded, const uint8_t* isDry, int n, Texel* texels, Texel* scratch, Encode encode) {
+    if (wetAdded) {
+      for (int i = 0; i < n; i++) {
+        scratch[i] = encode(float(values[i] + (isDry[i] == 0 ? wetAdded[i] : RealType(0.0))));
+      }
+    } else {
+      for (int i = 0; i < n; i++) {
+        scratch[i] = encode(float(values[i]));
+      }
+    }
+
+    int first = int(std::mismatch(scratch, scratch + n, texels).first - scratch);
+    if (first == n) {
+      return {n, -1};
+    }
+    int last = n - 1;
+    while (scratch[last] == texels[last]) {
+      last--;
+    }
+
+    std::copy(scratch + first, scratch + last + 1, texels + first);
+    return {first, last};
+  }
+
+  SWE_ISA_VARIANTS(Vec2i, encodeHeightMapRow)
+
+  template <class Texel, class Encode>
+  static bool encodeHeightMapRows(
+    const RealType* values,
+    const RealType* wetAdded,
+    int             pitch,
+    const uint8_t*  isDry,
+    int             nx,
+    int             ny,
+    uint8_t*        texels,
+    Vec2i&          dirtyMin,
+    Vec2i&          dirtyMax,
+    Encode          encode
+  ) {
+    dirtyMin = {nx, ny};
+    dirtyMax = {-1, -1};
+
+    std::mutex mutex;
+
+    Core::parallelFor(
+      0,
+      ny,
+      [&](int jBegin, int jEnd) {
+        std::vector<Texel> scratch(nx);
+        Vec2i              chunkMin = {nx, ny};
+        Vec2i              chunkMax = {-1, -1};
+
+        for (int j = jBegin; j < jEnd; j++) {
+          const RealType* src  = values + (size_t)j * pitch;
+          const RealType* add  = wetAdded ? wetAdded + (size_t)j * pitch : nullptr;
+          const uint8_t*  dry  = isDry ? isDry + (size_t)j * nx : nullptr;
+          Texel*          row  = reinterpret_cast<Texel*>(texels) + (size_t)j * nx;
+          Vec2i           span = SWE_ISA_CALL(encodeHeightMapRow, src, add, dry, nx, row, scratch.data(), encode);
+          if (span.x <= span.y) {
+            chunkMin.x = std::min(chunkMin.x, span.x);
+            chunkMax.x = std::max(chunkMax.x, span.y);
+            chunkMin.y = std::min(chunkMin.y, j);
+            chunkMax.y = j;
+          }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        dirtyMin.x = std::min(dirtyMin.x, chunkMin.x);
+        dirtyMin.y = std::min(dirtyMin.y, chunkMin.y);
+        dirtyMax.x = std::max(dirtyMax.x, chunkMax.x);
+        dirtyMax.y = std::max(dirtyMax.y, chunkMax.y);
+      },
+      std::max(1, 65536 / nx)
+    );
+
+    return dirtyMax.x >= 0;
+  }
+
+  bool encodeHeightMap(
+    HeightMapFormat format,
+    const RealType* values,
+    const RealType* wetAdded,
+    int             pitch,
+    const uint8_t*  isDry,
+    int             nx,
+    int             ny,
+    float           offset,
+    float           scale,
+    uint8_t*        texels,
+    Vec2i&          dirtyMin,
+    Vec2i&          dirtyMax
+  ) {
+    float invScale = scale != 0.0f ? 1.0f / scale : 0.0f;
+
+    switch (format) {
+    case HeightMapFormat::R32F:
+      return encodeHeightMapRows<float>(values, wetAdded, pitch, isDry, nx, ny, texels, dirtyMin, dirtyMax, [](float value) { return value; });
+    case HeightMapFormat::R16F:
+      return encodeHeightMapRows<uint16_t>(values, wetAdded, pitch, isDry, nx, ny, texels, dirtyMin, dirtyMax, [](float value) { return bx::halfFromFloat(value); });
+    case HeightMapFormat::R16:
+      return encodeHeightMapRows<uint16_t>(values, wetAdded, pitch, isDry, nx, ny, texels, dirtyMin, dirtyMax, [=](float value) {
+        return uint16_t(std::clamp((value - offset) * invScale, 0.0f, 1.0f) * 65535.0f + 0.5f);
+      });
+    case HeightMapFormat::R8:
+      return encodeHeightMapRows<uint8_t>(values, wetAdded, pitch, isDry, nx, ny, texels, dirtyMin, dirtyMax, [=](float value) {
+        return uint8_t(std::clamp((value - offset) * invScale, 0.0f, 1.0f) * 255.0f + 0.5f);
+      });
+    default:
+      assert(false);
+    }
+    return false;
+  }
+
   void setBlockBoundaryType(Blocks::Block* block, BoundaryType type) {
     if (block) {
       block->setBoundaryType(BoundaryEdge::Left, type);
@@ -12,6 +12,11 @@ namespace App {
   std::string scenarioTypeToString(ScenarioType type);
   std::string viewTypeToString(ViewType type);
   std::string boundaryTypeToString(BoundaryType type);
+  std::string heightMapFormatToString(HeightMapFormat format);
+  std::string compactFormatToString(CompactFormat format);
+
+  /// Size of a height map texel in bytes
+  int getHeightMapTexelSize(HeightMapFormat format);
 
   uint32_t colorToInt(float* color4);
 
@@ -20,6 +25,54 @@ namespace App {
   RealType getBlockValue(const Blocks::Block* block, ViewType type, int i, int j);
   RealType getBlockValue(const Blocks::Block* block, ViewType type, RealType x, RealType y);
 
+  /**
+   * Views are composed in the vertex shader as x * streamed + y * bathymetry for wet cells and x * streamed + z * bathymetry
+   * for dry cells (weights of getViewComposition). The streamed values are uploaded whenever the block changes, the bathymetry
+   * is static and uploaded once.
+   *
+   * With R32F, H + B streams h. The other formats quantise each texture over its own range, and a bathymetry range of
+   * several kilometres would drown the waves, so they stream the surface h + b of the wet cells (ViewType::HPlusB)
+   * and h of the dry cells, which both span a few metres.
+   *
+   * @return the view streamed for type (H, Hu, Hv or HPlusB), ViewType::Count if the view only shows the bathymetry.
+   */
+  ViewType getStreamedView(ViewType type, HeightMapFormat format);
+  Vec4f    getViewComposition(ViewType type, HeightMapFormat format);
+
+  /// Block array (including the ghost layer) holding the values of H, Hu, Hv or B
+  const Float2D<RealType>& getBlockValues(const Blocks::Block* block, ViewType type);
+
+  /**
+   * Computes the min/max of the view over the inner wet and dry cells (isDry[index] != 0, nx * ny) separately.
+   * Rows are processed in parallel; the reduction is branch-free so that it vectorises.
+   */
+  void computeViewRanges(const Blocks::Block* block, ViewType type, const uint8_t* isDry, Vec2f& minMaxWet, Vec2f& minMaxDry);
+
+  /**
+   * Encodes nx * ny values (rows pitch values apart) into height map texels of the given format. Normalised
+   * formats map [offset, offset + scale] to [0, 1], float formats store the values as they are.
+   * If wetAdded is not nullptr, it is added to the values of the wet cells (isDry[index] == 0, nx * ny).
+   *
+   * texels has to hold the texels of the previous upload: only changed texels are written and
+   * their bounding rectangle is returned in dirtyMin/dirtyMax (inclusive).
+   *
+   * @return false if no texel changed.
+   */
+  bool encodeHeightMap(
+    HeightMapFormat format,
+    const RealType* values,
+    const RealType* wetAdded,
+    int             pitch,
+    const uint8_t*  isDry,
+    int             nx,
+    int             ny,
+    float           offset,
+    float           scale,
+    uint8_t*        texels,
+    Vec2i&          dirtyMin,
+    Vec2i&          dirtyMax
+  );
+
   void setBlockBoundaryType(Blocks::Block* block, BoundaryType type);
 
   Vec3f    toVec3f(bx::Vec3 v);
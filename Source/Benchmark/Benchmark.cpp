@@ -0,0 +1,574 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Blocks/DimensionalSplitting.hpp"
+#include "Blocks/Ensemble.hpp"
+#include "Blocks/LayoutBlock.hpp"
+#include "Core/Isa.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/PerfCounters.hpp"
+#include "Scenarios/ArtificialTsunamiScenario.hpp"
+#include "Scenarios/RealisticScenario.hpp"
+
+/**
+ * Headless benchmark of the solver.
+ *
+ * Runs a scenario for a number of time steps without rendering and reports the cost of every phase,
+ * with hardware counters (IPC, estimated memory bandwidth, cycles per cell) where the platform allows.
+ */
+
+static void printUsage() {
+  std::printf(
+    "Usage: SWE-Bench [options]\n"
+    "  --scenario <name>  artificial (default), tohoku, tohoku-zoomed or chile\n"
+    "  --size <n>         Grid size n x n (default 1000)\n"
+    "  --steps <n>        Time steps (default 100)\n"
+    "  --no-counters      Only measure time\n"
+    "  --ensemble <n>     Run n variants of the scenario source instead (scaled and shifted displacement)\n"
+    "  --time <s>         Simulated time of every ensemble member (default 600)\n"
+    "  --layouts          Compare the sweeps on SoA, AoS and AoSoA cell layouts\n"
+    "  --block <k>        Run k steps of the same size per pass over the grid (temporal blocking)\n"
+    "  --sparse           Skip tiles of dry land in the sweeps\n"
+    "  --halo <k>         Split the grid into 4 x 4 blocks that exchange k ghost cell layers every k steps\n"
+    "  --out-of-core <f>  Store the grid in file f (deleted on exit) and stream it through memory in row bands\n"
+    "  --isa <name>       Force the kernel variant: generic, sse4.2, avx2 or avx512 (default: best supported)\n"
+    "  --bathymetry <f>   Storage of the bathymetry in the sweeps: full (default), fp16 or bf16\n"
+    "  --validate [tol]   Compare the sea surface with the bathymetry format to full precision instead, fail above\n"
+    "                     tol times the largest elevation (default 0.01)\n"
+  );
+}
+
+static Scenarios::Scenario* createScenario(std::string_view name, int n) {
+  if (name == "artificial") {
+    return new Scenarios::ArtificialTsunamiScenario(BoundaryType::Outflow);
+  } else if (name == "tohoku") {
+    return new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::Tohoku, BoundaryType::Outflow, n, n);
+  } else if (name == "tohoku-zoomed") {
+    return new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::TohokuZoomed, BoundaryType::Outflow, n, n);
+  } else if (name == "chile") {
+    return new Scenarios::RealisticScenario(Scenarios::RealisticScenarioType::Chile, BoundaryType::Outflow, n, n);
+  }
+  return nullptr;
+}
+
+/// Runs an ensemble and prints its throughput and how many cells reach each threshold with a given probability
+static int runEnsemble(const Scenarios::Scenario& scenario, int n, int members, RealType endTime) {
+  RealType left   = scenario.getBoundaryPos(BoundaryEdge::Left);
+  RealType right  = scenario.getBoundaryPos(BoundaryEdge::Right);
+  RealType bottom = scenario.getBoundaryPos(BoundaryEdge::Bottom);
+  RealType top    = scenario.getBoundaryPos(BoundaryEdge::Top);
+
+  auto loadStart = std::chrono::steady_clock::now();
+
+  Blocks::Ensemble ensemble(n, n, (right - left) / RealType(n), (top - bottom) / RealType(n));
+  ensemble.initialiseScenario(left, bottom, scenario);
+
+  // Fixed seed, so runs are comparable
+  std::mt19937                             random(42);
+  std::uniform_real_distribution<RealType> scale(RealType(0.5), RealType(1.5));
+  std::uniform_real_distribution<RealType> shift(RealType(-0.05), RealType(0.05));
+
+  std::vector<Blocks::EnsembleVariant> variants(members);
+  for (Blocks::EnsembleVariant& variant : variants) {
+    variant.scale  = scale(random);
+    variant.shiftX = shift(random) * (right - left);
+    variant.shiftY = shift(random) * (top - bottom);
+  }
+
+  auto    start   = std::chrono::steady_clock::now();
+  int64_t steps   = ensemble.run(variants, endTime);
+  double  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double  setup   = std::chrono::duration<double>(start - loadStart).count();
+
+  double cells = double(n) * n;
+
+  std::printf(
+    "Ensemble of %d members, %d x %d cells, %g s simulated, %s precision, %d threads\n",
+    members,
+    n,
+    n,
+    double(endTime),
+    sizeof(RealType) == sizeof(float) ? "single" : "double",
+    Core::getThreadCount()
+  );
+  std::printf("Shared setup: %.3f s, %.1f MiB\n", setup, ensemble.getMemoryUsage() / (1024.0 * 1024.0));
+  std::printf(
+    "Total: %.3f s, %.2f members/s, %lld steps (%.1f steps/s), %.3g cells/s\n",
+    seconds,
+    members / seconds,
+    (long long)steps,
+    steps / seconds,
+    cells * steps / seconds
+  );
+  if (ensemble.getFailedCount() > 0) {
+    std::printf("%d members failed\n", ensemble.getFailedCount());
+  }
+
+  std::printf("%-12s %10s %10s %10s\n", "Max surface", "P >= 10%", "P >= 50%", "P >= 90%");
+  const std::vector<RealType>& thresholds = ensemble.getThresholds();
+  for (int t = 0; t < (int)thresholds.size(); t++) {
+    int count[3] = {};
+    for (int j = 0; j < n; j++) {
+      for (int i = 0; i < n; i++) {
+        float p = ensemble.getExceedanceProbability(i, j, t);
+        count[0] += p >= 0.1f;
+        count[1] += p >= 0.5f;
+        count[2] += p >= 0.9f;
+      }
+    }
+    std::printf(">= %7.2f m %10d %10d %10d\n", double(thresholds[t]), count[0], count[1], count[2]);
+  }
+
+  return ensemble.getFailedCount() > 0 ? 1 : 0;
+}
+
+static void printPhaseHeader();
+static void printPhase(Core::ProfileScope scope, int steps, double cells);
+
+/// Runs the sweeps on a copy of block stored in Layout and checks that the water height matches the reference
+template <class Layout>
+static bool runLayout(const Blocks::Block& block, const Blocks::Block& reference, int steps, bool counters) {
+  Blocks::LayoutBlock<Layout> layoutBlock(block);
+
+  Core::PerfCounters::start(counters);
+  auto start = std::chrono::steady_clock::now();
+  for (int step = 0; step < steps; step++) {
+    layoutBlock.setGhostLayer();
+    layoutBlock.computeNumericalFluxes();
+    layoutBlock.updateUnknowns(layoutBlock.getMaxTimeStep());
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  int      nx      = reference.getNx();
+  int      ny      = reference.getNy();
+  RealType maxDiff = RealType(0.0);
+  for (int y = 1; y <= ny; y++) {
+    for (int x = 1; x <= nx; x++) {
+      maxDiff = std::max(maxDiff, std::abs(layoutBlock.getValue(QuantityH, x, y) - reference.getWaterHeight()[y][x]));
+    }
+  }
+
+  double cells = double(nx) * ny;
+  std::printf("%s: %.3f ms/step, %.3f ns/cell, %.1f MiB", Layout::Name, seconds * 1e3 / steps, seconds * 1e9 / (steps * cells), layoutBlock.getMemoryUsage() / (1024.0 * 1024.0));
+  std::printf(maxDiff == RealType(0.0) ? "\n" : ", differs from the block by up to %g\n", double(maxDiff));
+  printPhaseHeader();
+  for (Core::ProfileScope scope : {Core::ProfileScope::XSweep, Core::ProfileScope::YSweep}) {
+    printPhase(scope, steps, cells);
+  }
+
+  Core::PerfCounters::stop();
+  return maxDiff == RealType(0.0) && !layoutBlock.hasError();
+}
+
+/// Compares the cell layouts, see Types/CellLayout.hpp
+static int runLayouts(const Scenarios::Scenario& scenario, int n, int steps, bool counters) {
+  RealType left   = scenario.getBoundaryPos(BoundaryEdge::Left);
+  RealType right  = scenario.getBoundaryPos(BoundaryEdge::Right);
+  RealType bottom = scenario.getBoundaryPos(BoundaryEdge::Bottom);
+  RealType top    = scenario.getBoundaryPos(BoundaryEdge::Top);
+
+  Blocks::DimensionalSplittingBlock block(n, n, (right - left) / RealType(n), (top - bottom) / RealType(n));
+  block.initialiseScenario(left, bottom, scenario);
+
+  Blocks::DimensionalSplittingBlock reference(n, n, block.getDx(), block.getDy());
+  reference.initialiseScenario(left, bottom, scenario);
+  for (int step = 0; step < steps; step++) {
+    reference.setGhostLayer();
+    reference.computeNumericalFluxes();
+    reference.updateUnknowns(reference.getMaxTimeStep());
+  }
+
+  std::printf(
+    "Cell layouts, %d x %d cells, %d steps, %s precision, %d threads\n",
+    block.getNx(),
+    block.getNy(),
+    steps,
+    sizeof(RealType) == sizeof(float) ? "single" : "double",
+    Core::getThreadCount()
+  );
+
+  bool success = true;
+  success &= runLayout<SoALayout>(block, reference, steps, counters);
+  success &= runLayout<AoSLayout>(block, reference, steps, counters);
+  success &= runLayout<AoSoALayout<16 / sizeof(RealType)>>(block, reference, steps, counters); // SSE/SIMD128 width
+  success &= runLayout<AoSoALayout<32 / sizeof(RealType)>>(block, reference, steps, counters); // AVX width
+  return success ? 0 : 1;
+}
+
+/**
+ * Runs the grid as tiles x tiles blocks that exchange their halo every haloWidth steps, with the time step of the
+ * first step, and compares the water height with a single block.
+ */
+static int runHalo(const Scenarios::Scenario& scenario, int n, int steps, int haloWidth, int tiles) {
+  RealType left   = scenario.getBoundaryPos(BoundaryEdge::Left);
+  RealType right  = scenario.getBoundaryPos(BoundaryEdge::Right);
+  RealType bottom = scenario.getBoundaryPos(BoundaryEdge::Bottom);
+  RealType top    = scenario.getBoundaryPos(BoundaryEdge::Top);
+
+  int size = n / tiles;
+  if (size * tiles != n || size < haloWidth) {
+    std::fprintf(stderr, "The size has to be a multiple of %d and at least %d per block\n", tiles, haloWidth);
+    return 1;
+  }
+
+  Blocks::DimensionalSplittingBlock reference(n, n, (right - left) / RealType(n), (top - bottom) / RealType(n));
+  reference.initialiseScenario(left, bottom, scenario);
+  reference.setGhostLayer();
+  reference.computeMaxTimeStep();
+  RealType dt = reference.getMaxTimeStep();
+
+  std::vector<std::unique_ptr<Blocks::DimensionalSplittingBlock>> blocks;
+  for (int j = 0; j < tiles; j++) {
+    for (int i = 0; i < tiles; i++) {
+      blocks.push_back(std::make_unique<Blocks::DimensionalSplittingBlock>(size, size, reference.getDx(), reference.getDy(), haloWidth));
+      blocks.back()->initialiseScenario(left + i * size * reference.getDx(), bottom + j * size * reference.getDy(), scenario);
+    }
+  }
+  auto getBlock = [&](int i, int j) -> Blocks::DimensionalSplittingBlock& { return *blocks[size_t(j) * tiles + i]; };
+
+  double exchangeSeconds = 0.0;
+  int    exchanges       = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int step = 0; step < steps; step += haloWidth) {
+    auto exchangeStart = std::chrono::steady_clock::now();
+    for (auto& block : blocks) {
+      block->setGhostLayer();
+    }
+    for (int j = 0; j < tiles; j++) {
+      for (int i = 0; i + 1 < tiles; i++) {
+        getBlock(i, j).copyHalo(BoundaryEdge::Right, getBlock(i + 1, j));
+        getBlock(i + 1, j).copyHalo(BoundaryEdge::Left, getBlock(i, j));
+      }
+    }
+    for (int j = 0; j + 1 < tiles; j++) {
+      for (int i = 0; i < tiles; i++) {
+        getBlock(i, j).copyHalo(BoundaryEdge::Top, getBlock(i, j + 1));
+        getBlock(i, j + 1).copyHalo(BoundaryEdge::Bottom, getBlock(i, j));
+      }
+    }
+    exchangeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - exchangeStart).count();
+    exchanges++;
+
+    int stepCount = std::min(haloWidth, steps - step);
+    Core::parallelFor(0, int(blocks.size()), [&](int begin, int end) {
+      for (int b = begin; b < end; b++) {
+        blocks[b]->simulateHaloSteps(dt, stepCount);
+      }
+    });
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  for (int step = 0; step < steps; step++) {
+    reference.setGhostLayer();
+    reference.simulateTimeStep(dt);
+  }
+
+  RealType maxDiff = RealType(0.0);
+  bool     error   = reference.hasError();
+  for (int j = 0; j < tiles; j++) {
+    for (int i = 0; i < tiles; i++) {
+      const Float2D<RealType>& h = getBlock(i, j).getWaterHeight();
+      for (int y = 1; y <= size; y++) {
+        for (int x = 1; x <= size; x++) {
+          maxDiff = std::max(maxDiff, std::abs(h[y][x] - reference.getWaterHeight()[j * size + y][i * size + x]));
+        }
+      }
+      error |= getBlock(i, j).hasError();
+    }
+  }
+
+  double cells = double(n) * n;
+  std::printf(
+    "%d x %d blocks of %d x %d cells, halo width %d, %d steps, %s precision, %d threads\n",
+    tiles,
+    tiles,
+    size,
+    size,
+    haloWidth,
+    steps,
+    sizeof(RealType) == sizeof(float) ? "single" : "double",
+    Core::getThreadCount()
+  );
+  std::printf("Exchanges: %d (%.3f ms each)\n", exchanges, exchangeSeconds * 1e3 / exchanges);
+  std::printf("Total: %.3f ms/step, %.3g cells/s\n", seconds * 1e3 / steps, cells * steps / seconds);
+  std::printf(maxDiff == RealType(0.0) ? "Same water height as a single block\n" : "Differs from a single block by up to %g\n", double(maxDiff));
+
+  return error || maxDiff != RealType(0.0) ? 1 : 0;
+}
+
+/**
+ * Runs the grid with the bathymetry in format next to a block in full precision, both with the time steps of the
+ * latter, and compares the sea surface of the wet cells. Fails if it differs by more than tolerance times the
+ * largest surface elevation of the reference.
+ */
+static int runBathymetryValidation(const Scenarios::Scenario& scenario, int n, int steps, CompactFormat format, RealType tolerance) {
+  RealType left   = scenario.getBoundaryPos(BoundaryEdge::Left);
+  RealType right  = scenario.getBoundaryPos(BoundaryEdge::Right);
+  RealType bottom = scenario.getBoundaryPos(BoundaryEdge::Bottom);
+  RealType top    = scenario.getBoundaryPos(BoundaryEdge::Top);
+
+  Blocks::DimensionalSplittingBlock reference(n, n, (right - left) / RealType(n), (top - bottom) / RealType(n));
+  reference.initialiseScenario(left, bottom, scenario);
+
+  Blocks::DimensionalSplittingBlock block(n, n, reference.getDx(), reference.getDy());
+  block.initialiseScenario(left, bottom, scenario);
+  block.setBathymetryFormat(format);
+
+  // Largest difference of the sea surface in the wet cells and largest elevation of the reference
+  auto compareSurface = [&](RealType& o_maxSurface) {
+    RealType maxDiff = RealType(0.0);
+    o_maxSurface     = RealType(0.0);
+    for (int y = 1; y <= n; y++) {
+      for (int x = 1; x <= n; x++) {
+        if (reference.getBathymetry()[y][x] > RealType(0.0)) {
+          continue;
+        }
+        RealType surface = reference.getWaterHeight()[y][x] + reference.getBathymetry()[y][x];
+        maxDiff          = std::max(maxDiff, std::abs(block.getWaterHeight()[y][x] + block.getBathymetry()[y][x] - surface));
+        o_maxSurface     = std::max(o_maxSurface, std::abs(surface));
+      }
+    }
+    return maxDiff;
+  };
+
+  RealType maxBathymetryDiff = RealType(0.0);
+  for (int y = 1; y <= n; y++) {
+    for (int x = 1; x <= n; x++) {
+      maxBathymetryDiff = std::max(maxBathymetryDiff, std::abs(block.getBathymetry()[y][x] - reference.getBathymetry()[y][x]));
+    }
+  }
+  RealType maxSurface  = RealType(0.0);
+  RealType initialDiff = compareSurface(maxSurface);
+
+  for (int step = 0; step < steps; step++) {
+    reference.setGhostLayer();
+    reference.computeMaxTimeStep();
+    RealType dt = reference.getMaxTimeStep();
+    reference.simulateTimeStep(dt);
+
+    block.setGhostLayer();
+    block.simulateTimeStep(dt);
+  }
+
+  RealType finalDiff = compareSurface(maxSurface);
+  RealType relative  = maxSurface > RealType(0.0) ? finalDiff / maxSurface : RealType(0.0);
+  bool     success   = !reference.hasError() && !block.hasError() && relative <= tolerance;
+
+  std::printf(
+    "%d x %d cells, %d steps, %s precision, bathymetry in %s\n",
+    n,
+    n,
+    steps,
+    sizeof(RealType) == sizeof(float) ? "single" : "double",
+    format == CompactFormat::Half ? "fp16" : format == CompactFormat::BFloat16 ? "bf16" : "full precision"
+  );
+  std::printf("Bathymetry rounded by up to %g m, initial sea surface differs by up to %g m\n", double(maxBathymetryDiff), double(initialDiff));
+  std::printf(
+    "Sea surface differs by up to %g m after %d steps, %.3g%% of the largest elevation (%g m), tolerance %.3g%%: %s\n",
+    double(finalDiff),
+    steps,
+    double(relative) * 100.0,
+    double(maxSurface),
+    double(tolerance) * 100.0,
+    success ? "passed" : "failed"
+  );
+
+  return success ? 0 : 1;
+}
+
+static void printPhase(Core::ProfileScope scope, int steps, double cells) {
+  const Core::PerfTotals& totals = Core::PerfCounters::getTotals(scope);
+  if (totals.calls == 0) {
+    return;
+  }
+
+  double cycles = double(totals.counts[(int)Core::PerfEvent::Cycles]);
+
+  std::printf("%-14s %9.3f %9.3f", Core::Profiler::getName(scope), totals.seconds * 1e3 / steps, totals.seconds * 1e9 / (steps * cells));
+  if (Core::PerfCounters::isAvailable(Core::PerfEvent::Cycles)) {
+    std::printf(" %11.2f %6.2f %8.2f", cycles / (steps * cells), totals.getIpc(), totals.getBytesPerSecond() * 1e-9);
+  }
+  if (Core::PerfCounters::isAvailable(Core::PerfEvent::VectorInstructions)) {
+    std::printf(" %7.1f%%", totals.getVectorFraction() * 100.0);
+  }
+  std::printf("\n");
+}
+
+static void printPhaseHeader() {
+  std::printf("%-14s %9s %9s", "Phase", "ms/step", "ns/cell");
+  if (Core::PerfCounters::isAvailable(Core::PerfEvent::Cycles)) {
+    std::printf(" %11s %6s %8s", "cycles/cell", "IPC", "GB/s");
+  }
+  if (Core::PerfCounters::isAvailable(Core::PerfEvent::VectorInstructions)) {
+    std::printf(" %8s", "vector");
+  }
+  std::printf("\n");
+}
+
+int main(int argc, char** argv) {
+  std::string_view scenarioName = "artificial";
+  int              n            = 1000;
+  int              steps        = 100;
+  bool             counters     = true;
+  int              members      = 0;
+  bool             layouts      = false;
+  int              blockSteps   = 1;
+  int              haloWidth    = 0;
+  bool             sparse       = false;
+  std::string      storagePath;
+  CompactFormat    bathymetry   = CompactFormat::Full;
+  RealType         tolerance    = RealType(-1.0);
+  RealType         endTime      = RealType(600.0);
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg     = argv[i];
+    bool             hasNext = i + 1 < argc;
+    if (arg == "--scenario" && hasNext) {
+      scenarioName = argv[++i];
+    } else if (arg == "--size" && hasNext) {
+      n = std::atoi(argv[++i]);
+    } else if (arg == "--steps" && hasNext) {
+      steps = std::atoi(argv[++i]);
+    } else if (arg == "--no-counters") {
+      counters = false;
+    } else if (arg == "--ensemble" && hasNext) {
+      members = std::atoi(argv[++i]);
+    } else if (arg == "--time" && hasNext) {
+      endTime = RealType(std::atof(argv[++i]));
+    } else if (arg == "--layouts") {
+      layouts = true;
+    } else if (arg == "--block" && hasNext) {
+      blockSteps = std::atoi(argv[++i]);
+    } else if (arg == "--sparse") {
+      sparse = true;
+    } else if (arg == "--halo" && hasNext) {
+      haloWidth = std::atoi(argv[++i]);
+    } else if (arg == "--out-of-core" && hasNext) {
+      storagePath = argv[++i];
+    } else if (arg == "--bathymetry" && hasNext) {
+      std::string_view name = argv[++i];
+      bathymetry            = name == "fp16" ? CompactFormat::Half : name == "bf16" ? CompactFormat::BFloat16 : CompactFormat::Full;
+      if (bathymetry == CompactFormat::Full && name != "full") {
+        printUsage();
+        return 1;
+      }
+    } else if (arg == "--validate") {
+      bool hasTolerance = hasNext && argv[i + 1][0] != '-';
+      tolerance         = hasTolerance ? RealType(std::atof(argv[++i])) : RealType(0.01);
+    } else if (arg == "--isa" && hasNext) {
+      Core::Isa isa = Core::Isa::Generic;
+      if (!Core::parseIsa(argv[++i], isa) || !Core::setIsa(isa)) {
+        std::fprintf(stderr, "Instruction set %s is not available\n", argv[i]);
+        return 1;
+      }
+    } else {
+      printUsage();
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  if (n < 2 || steps < 1 || members < 0 || blockSteps < 1 || haloWidth < 0 || !(endTime > RealType(0.0))) {
+    printUsage();
+    return 1;
+  }
+
+  std::printf("Kernels: %s (best supported: %s)\n", Core::getIsaName(Core::getIsa()), Core::getIsaName(Core::getBestIsa()));
+
+  std::unique_ptr<Scenarios::Scenario> scenario(createScenario(scenarioName, n));
+  if (!scenario || !scenario->loadSuccess()) {
+    std::fprintf(stderr, "Failed to load scenario %s\n", scenarioName.data());
+    return 1;
+  }
+
+  if (members > 0) {
+    return runEnsemble(*scenario, n, members, endTime);
+  }
+  if (layouts) {
+    return runLayouts(*scenario, n, steps, counters);
+  }
+  if (haloWidth > 0) {
+    return runHalo(*scenario, n, steps, haloWidth, 4);
+  }
+  if (tolerance >= RealType(0.0)) {
+    return runBathymetryValidation(*scenario, n, steps, bathymetry, tolerance);
+  }
+
+  RealType left   = scenario->getBoundaryPos(BoundaryEdge::Left);
+  RealType right  = scenario->getBoundaryPos(BoundaryEdge::Right);
+  RealType bottom = scenario->getBoundaryPos(BoundaryEdge::Bottom);
+  RealType top    = scenario->getBoundaryPos(BoundaryEdge::Top);
+
+  Blocks::DimensionalSplittingBlock block(n, n, (right - left) / RealType(n), (top - bottom) / RealType(n), 1, storagePath);
+  block.initialiseScenario(left, bottom, *scenario);
+  block.setSparseTiles(sparse);
+  block.setBathymetryFormat(bathymetry);
+
+  // Warm up caches and page in the arrays
+  block.setGhostLayer();
+  block.computeMaxTimeStep();
+  block.simulateTimeStep(block.getMaxTimeStep());
+
+  if (!Core::PerfCounters::start(counters) && counters) {
+    std::fprintf(stderr, "Hardware counters unavailable: %s\n", Core::PerfCounters::getError().c_str());
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  if (blockSteps > 1 || block.hasFileStorage()) {
+    // The time step is only computed once, later ones come from the wave speeds of the previous pass (which also
+    // avoids extra passes over a file)
+    block.setGhostLayer();
+    block.computeMaxTimeStep();
+    for (int step = 0; step < steps; step += blockSteps) {
+      block.simulateTimeSteps(block.getMaxTimeStep(), std::min(blockSteps, steps - step));
+    }
+  }
+  for (int step = 0; step < steps && blockSteps == 1 && !block.hasFileStorage(); step++) {
+    {
+      SWE_PERF_SCOPE(GhostLayer);
+      block.setGhostLayer();
+    }
+    {
+      SWE_PERF_SCOPE(MaxTimeStep);
+      block.computeMaxTimeStep();
+    }
+    block.simulateTimeStep(block.getMaxTimeStep());
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  double cells = double(n) * n;
+
+  std::printf(
+    "%s, %d x %d cells, %d steps, %s precision, %d threads\n", scenarioName.data(), n, n, steps, sizeof(RealType) == sizeof(float) ? "single" : "double", Core::getThreadCount()
+  );
+  if (blockSteps > 1) {
+    std::printf("Temporal blocking: %d steps per pass\n", blockSteps);
+  }
+  if (block.hasFileStorage()) {
+    std::printf("Out of core: %.1f MiB in %s\n", 4.0 * sizeof(RealType) * (n + 2) * (n + 2) / (1024.0 * 1024.0), storagePath.c_str());
+  }
+  if (bathymetry != CompactFormat::Full) {
+    std::printf("Bathymetry: %s\n", bathymetry == CompactFormat::Half ? "fp16" : "bf16");
+  }
+  if (sparse) {
+    std::printf("Sparse tiles: %.1f%% of the tiles swept, %.1f MiB\n", block.getActiveTileFraction() * 100.0f, block.getMemoryUsage() / (1024.0 * 1024.0));
+  }
+  printPhaseHeader();
+
+  for (Core::ProfileScope scope : {Core::ProfileScope::GhostLayer, Core::ProfileScope::MaxTimeStep, Core::ProfileScope::XSweep, Core::ProfileScope::YSweep, Core::ProfileScope::BlockedSteps}) {
+    printPhase(scope, steps, cells);
+  }
+
+  std::printf("Total: %.3f ms/step, %.1f steps/s, %.3g cells/s\n", seconds * 1e3 / steps, steps / seconds, cells * steps / seconds);
+
+  Core::PerfCounters::stop();
+  return block.hasError() ? 1 : 0;
+}
@@ -24,6 +24,7 @@
 
 #include "Block.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstring>
@@ -31,47 +32,84 @@
 #include <limits>
 #include <memory>
 
+#include "Core/Trace.hpp"
+
 static constexpr RealType GRAVITY = 9.81f;
 
-Blocks::Block::Block(int nx, int ny, RealType dx, RealType dy):
+/**
+ * Sets the ghost cell layers 2 to haloWidth by mirroring the cells inside at the boundary, layer d gets the
+ * values of inner cell d multiplied with the sign of its edge. Expects the first layer (incl. corners) to be set.
+ */
+static void setDeepGhostLayers(Float2D<RealType>& values, int nx, int ny, int haloWidth, const RealType sign[4]) {
+  for (int d = 2; d <= haloWidth; d++) {
+    for (int j = 0; j <= ny + 1; j++) {
+      values[j][1 - d]  = sign[BoundaryEdge::Left] * values[j][d];
+      values[j][nx + d] = sign[BoundaryEdge::Right] * values[j][nx + 1 - d];
+    }
+  }
+  for (int d = 2; d <= haloWidth; d++) {
+    for (int i = 1 - haloWidth; i <= nx + haloWidth; i++) {
+      values[1 - d][i]  = sign[BoundaryEdge::Bottom] * values[d][i];
+      values[ny + d][i] = sign[BoundaryEdge::Top] * values[ny + 1 - d][i];
+    }
+  }
+}
+
+// Bytes of one array in the file storage, rounded up so every array starts on a new page
+static size_t getStorageArrayBytes(int nx, int ny, int haloWidth) {
+  size_t bytes = sizeof(RealType) * size_t(nx + 2 * haloWidth) * size_t(ny + 2 * haloWidth);
+  return (bytes + 65535) / 65536 * 65536;
+}
+
+// Creates the file storage for h, hu, hv and b, or returns nullptr to allocate them on the heap
+static std::unique_ptr<Core::MappedStorage> createStorage(const std::string& path, int nx, int ny, int haloWidth) {
+  if (path.empty()) {
+    return nullptr;
+  }
+
+  std::unique_ptr<Core::MappedStorage> storage = Core::MappedStorage::create(path, 4 * getStorageArrayBytes(nx, ny, haloWidth));
+  if (!storage) {
+    std::cerr << "Failed to create the storage file " << path << ", allocating the grid in memory" << std::endl;
+  }
+  return storage;
+}
+
+// Memory of array index in the storage, nullptr to allocate it
+static RealType* getStorageArray(Core::MappedStorage* storage, int index, int nx, int ny, int haloWidth) {
+  return storage ? reinterpret_cast<RealType*>(storage->getData() + index * getStorageArrayBytes(nx, ny, haloWidth)) : nullptr;
+}
+
+Blocks::Block::Block(int nx, int ny, RealType dx, RealType dy, int haloWidth, const std::string& storagePath):
   nx_(nx),
   ny_(ny),
   dx_(dx),
   dy_(dy),
-  h_(ny + 2, nx + 2),
-  hu_(ny + 2, nx + 2),
-  hv_(ny + 2, nx + 2),
-  b_(ny + 2, nx + 2),
+  haloWidth_(haloWidth),
+  storage_(createStorage(storagePath, nx, ny, haloWidth)),
+  h_(ny + 2, nx + 2, haloWidth - 1, getStorageArray(storage_.get(), 0, nx, ny, haloWidth)),
+  hu_(ny + 2, nx + 2, haloWidth - 1, getStorageArray(storage_.get(), 1, nx, ny, haloWidth)),
+  hv_(ny + 2, nx + 2, haloWidth - 1, getStorageArray(storage_.get(), 2, nx, ny, haloWidth)),
+  b_(ny + 2, nx + 2, haloWidth - 1, getStorageArray(storage_.get(), 3, nx, ny, haloWidth)),
   maxTimeStep_(0),
   offsetX_(0),
   offsetY_(0) {
 
+  // Mirroring the deeper layers needs as many inner cells
+  assert(haloWidth >= 1 && haloWidth <= std::min(nx, ny));
+
   for (int i = 0; i < 4; i++) {
     boundary_[i] = BoundaryType::Count; // (invalid)
   }
 }
 
-void Blocks::Block::initialiseScenario(RealType offsetX, RealType offsetY, const Scenarios::Scenario& scenario) {
+void Blocks::Block::initialiseScenario(RealType offsetX, RealType offsetY, const Scenarios::Scenario& scenario, Core::Progress* progress) {
+  SWE_TRACE_ZONE("Initialise Scenario");
+
   offsetX_ = offsetX;
   offsetY_ = offsetY;
 
-  // Initialize water height and discharge
-  for (int j = 1; j <= ny_; j++) {
-    for (int i = 1; i <= nx_; i++) {
-      RealType x = offsetX + (i - RealType(0.5)) * dx_;
-      RealType y = offsetY + (j - RealType(0.5)) * dy_;
-      h_[j][i]   = scenario.getWaterHeight(x, y);
-      hu_[j][i]  = scenario.getMomentumU(x, y);
-      hv_[j][i]  = scenario.getMomentumV(x, y);
-    }
-  }
-
-  // Initialize bathymetry
-  for (int j = 0; j <= ny_ + 1; j++) {
-    for (int i = 0; i <= nx_ + 1; i++) {
-      b_[j][i] = scenario.getBathymetry(offsetX + (i - RealType(0.5)) * dx_, offsetY + (j - RealType(0.5f)) * dy_);
-    }
-  }
+  // Initialize water height, discharge and bathymetry (incl. ghost layer) in a single pass
+  scenario.sampleGrid(offsetX, offsetY, dx_, dy_, nx_, ny_, h_, hu_, hv_, b_, progress);
 
   // Obtain boundary conditions for all four edges from scenario
   setBoundaryType(BoundaryEdge::Left, scenario.getBoundaryType(BoundaryEdge::Left));
@@ -123,11 +161,22 @@ const Float2D<RealType>& Blocks::Block::getDischargeHv() const { return hv_; }
 
 const Float2D<RealType>& Blocks::Block::getBathymetry() const { return b_; }
 
+size_t Blocks::Block::getMemoryUsage() const { return 4 * sizeof(RealType) * h_.getAllocatedSize(); }
+
 void Blocks::Block::simulateTimeStep(RealType dt) {
+  SWE_TRACE_ZONE("Time Step");
+
   computeNumericalFluxes();
   updateUnknowns(dt);
 }
 
+void Blocks::Block::simulateTimeSteps(RealType dt, int steps) {
+  for (int step = 0; step < steps; step++) {
+    setGhostLayer();
+    simulateTimeStep(dt);
+  }
+}
+
 RealType Blocks::Block::simulate(RealType tStart, RealType tEnd) {
   RealType t = tStart;
   do {
@@ -153,6 +202,8 @@ void Blocks::Block::setBoundaryType(BoundaryEdge edge, BoundaryType boundaryType
   }
 }
 
+BoundaryType Blocks::Block::getBoundaryType(BoundaryEdge edge) const { return boundary_[edge]; }
+
 void Blocks::Block::setBoundaryBathymetry() {
   // Set bathymetry values in the ghost layer, if necessary
   if (boundary_[BoundaryEdge::Left] == BoundaryType::Outflow || boundary_[BoundaryEdge::Left] == BoundaryType::Wall) {
@@ -177,11 +228,21 @@ void Blocks::Block::setBoundaryBathymetry() {
   b_[0][nx_ + 1]       = b_[1][nx_];
   b_[ny_ + 1][0]       = b_[ny_][1];
   b_[ny_ + 1][nx_ + 1] = b_[ny_][nx_];
+
+  if (haloWidth_ > 1) {
+    const RealType sign[4] = {RealType(1.0), RealType(1.0), RealType(1.0), RealType(1.0)};
+    setDeepGhostLayers(b_, nx_, ny_, haloWidth_, sign);
+  }
 }
 
-void Blocks::Block::setGhostLayer() { setBoundaryConditions(); }
+void Blocks::Block::setGhostLayer() {
+  SWE_TRACE_ZONE("Ghost Layer");
+  setBoundaryConditions();
+}
 
 void Blocks::Block::computeMaxTimeStep(const RealType dryTol, const RealType cfl) {
+  SWE_TRACE_ZONE("Max Time Step");
+
   // Initialize the maximum wave speed
   RealType maximumWaveSpeed = RealType(0.0);
 
@@ -346,12 +407,103 @@ void Blocks::Block::setBoundaryConditions() {
   h_[ny_ + 1][nx_ + 1]  = h_[ny_][nx_];
   hu_[ny_ + 1][nx_ + 1] = hu_[ny_][nx_];
   hv_[ny_ + 1][nx_ + 1] = hv_[ny_][nx_];
+
+  if (haloWidth_ > 1) {
+    // Deeper layers mirror the cells inside, the momentum normal to a wall is negated
+    RealType wallSign[4];
+    for (int edge = 0; edge < 4; edge++) {
+      wallSign[edge] = boundary_[edge] == BoundaryType::Wall ? RealType(-1.0) : RealType(1.0);
+    }
+    const RealType one[4]   = {RealType(1.0), RealType(1.0), RealType(1.0), RealType(1.0)};
+    const RealType signU[4] = {wallSign[BoundaryEdge::Left], wallSign[BoundaryEdge::Right], RealType(1.0), RealType(1.0)};
+    const RealType signV[4] = {RealType(1.0), RealType(1.0), wallSign[BoundaryEdge::Bottom], wallSign[BoundaryEdge::Top]};
+
+    setDeepGhostLayers(h_, nx_, ny_, haloWidth_, one);
+    setDeepGhostLayers(hu_, nx_, ny_, haloWidth_, signU);
+    setDeepGhostLayers(hv_, nx_, ny_, haloWidth_, signV);
+  }
+}
+
+void Blocks::Block::copyHalo(BoundaryEdge edge, const Block& neighbour) {
+  SWE_TRACE_ZONE("Copy Halo");
+
+  int k = haloWidth_;
+  assert(neighbour.haloWidth_ == k);
+
+  // Ghost cell (i, j) of this block gets cell (i + shiftX, j + shiftY) of the neighbour
+  int iBegin = 1 - k, iEnd = nx_ + k, jBegin = 1 - k, jEnd = ny_ + k, shiftX = 0, shiftY = 0;
+  switch (edge) {
+  case BoundaryEdge::Left:
+    assert(neighbour.ny_ == ny_);
+    iEnd   = 0;
+    shiftX = neighbour.nx_;
+    break;
+  case BoundaryEdge::Right:
+    assert(neighbour.ny_ == ny_);
+    iBegin = nx_ + 1;
+    shiftX = -nx_;
+    break;
+  case BoundaryEdge::Bottom:
+    assert(neighbour.nx_ == nx_);
+    jEnd   = 0;
+    shiftY = neighbour.ny_;
+    break;
+  case BoundaryEdge::Top:
+    assert(neighbour.nx_ == nx_);
+    jBegin = ny_ + 1;
+    shiftY = -ny_;
+    break;
+  }
+
+  for (int j = jBegin; j <= jEnd; j++) {
+    for (int i = iBegin; i <= iEnd; i++) {
+      h_[j][i]  = neighbour.h_[j + shiftY][i + shiftX];
+      hu_[j][i] = neighbour.hu_[j + shiftY][i + shiftX];
+      hv_[j][i] = neighbour.hv_[j + shiftY][i + shiftX];
+      b_[j][i]  = neighbour.b_[j + shiftY][i + shiftX];
+    }
+  }
 }
 
 int Blocks::Block::getNx() const { return nx_; }
 
 int Blocks::Block::getNy() const { return ny_; }
 
+int Blocks::Block::getHaloWidth() const { return haloWidth_; }
+
+bool Blocks::Block::hasFileStorage() const { return storage_ != nullptr; }
+
+void Blocks::Block::prefetchRows(int yBegin, int yEnd) {
+  if (!storage_) {
+    return;
+  }
+
+  // Rows are contiguous in every array, the first one lies at -halo
+  int    halo       = haloWidth_ - 1;
+  size_t rowBytes   = sizeof(RealType) * size_t(h_.getStride());
+  size_t arrayBytes = getStorageArrayBytes(nx_, ny_, haloWidth_);
+  yBegin            = std::max(yBegin, -halo);
+  yEnd              = std::min(yEnd, ny_ + 2 + halo);
+  for (int array = 0; array < 4 && yBegin < yEnd; array++) {
+    storage_->prefetch(array * arrayBytes + size_t(yBegin + halo) * rowBytes, size_t(yEnd - yBegin) * rowBytes);
+  }
+}
+
+void Blocks::Block::releaseRows(int yBegin, int yEnd) {
+  if (!storage_) {
+    return;
+  }
+
+  int    halo       = haloWidth_ - 1;
+  size_t rowBytes   = sizeof(RealType) * size_t(h_.getStride());
+  size_t arrayBytes = getStorageArrayBytes(nx_, ny_, haloWidth_);
+  yBegin            = std::max(yBegin, -halo);
+  yEnd              = std::min(yEnd, ny_ + 2 + halo);
+  for (int array = 0; array < 4 && yBegin < yEnd; array++) {
+    storage_->release(array * arrayBytes + size_t(yBegin + halo) * rowBytes, size_t(yEnd - yBegin) * rowBytes);
+  }
+}
+
 RealType Blocks::Block::getDx() const { return dx_; }
 
 RealType Blocks::Block::getDy() const { return dy_; }
@@ -24,6 +24,10 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+
+#include "Core/MappedStorage.hpp"
 #include "Scenarios/Scenario.hpp"
 #include "Types/BoundaryEdge.hpp"
 #include "Types/BoundaryType.hpp"
@@ -40,6 +44,11 @@ namespace Blocks {
     // Mesh size dx and dy:
     RealType dx_; ///< Mesh size of the Cartesian grid in x-direction
     RealType dy_; ///< Mesh size of the Cartesian grid in y-direction
+    // Number of ghost cell layers on each side:
+    int haloWidth_; ///< Layers 2 to haloWidth_ lie at indices -1, -2, ... and nx + 2, nx + 3, ... (ny + 2, ...)
+
+    /// File that holds h, hu, hv and b one after another, nullptr if they are allocated on the heap
+    std::unique_ptr<Core::MappedStorage> storage_;
 
     // Define arrays for unknowns:
     // h (water level) and u, v (velocity in x and y direction)
@@ -72,12 +81,22 @@ namespace Blocks {
      * and b (bathymetry) are defined on grid indices [0,..,nx+1]*[0,..,ny+1]
      * -> computational domain is [1,..,nx]*[1,..,ny]
      * -> plus ghost cell layer
+     * -> plus haloWidth - 1 further ghost cell layers outside of it
+     *
+     * With a storagePath the arrays are stored in a file mapped into memory
+     * (see Core::MappedStorage), for grids larger than the main memory.
+     * They are allocated on the heap if the file cannot be created.
      *
      * The constructor is protected: no instances of Blocks::Block can be
      * generated.
      *
      */
-    Block(int nx, int ny, RealType dx, RealType dy);
+    Block(int nx, int ny, RealType dx, RealType dy, int haloWidth = 1, const std::string& storagePath = std::string());
+
+    /// Starts loading rows [yBegin, yEnd) of all arrays in the background if they are stored in a file
+    void prefetchRows(int yBegin, int yEnd);
+    /// Starts writing rows [yBegin, yEnd) of all arrays back and releases their memory if they are stored in a file
+    void releaseRows(int yBegin, int yEnd);
 
     /**
      * Sets the bathymetry on BoundaryType::Outflow or BoundaryType::Wall.
@@ -112,8 +131,9 @@ namespace Blocks {
      *
      * @param scenario Scenarios::Scenario, which is used during the setup.
      * @param useMultipleBlocks Are there multiple blocks?
+     * @param progress Optional progress of the sampling, which leaves the block partially initialised if cancelled.
      */
-    void initialiseScenario(RealType offsetX, RealType offsetY, const Scenarios::Scenario& scenario);
+    void initialiseScenario(RealType offsetX, RealType offsetY, const Scenarios::Scenario& scenario, Core::Progress* progress = nullptr);
 
     /// Sets the water height according to a given function
     /**
@@ -162,6 +182,9 @@ namespace Blocks {
      */
     void setBoundaryType(BoundaryEdge edge, BoundaryType boundaryType);
 
+    /// Returns the boundary type of a block boundary
+    BoundaryType getBoundaryType(BoundaryEdge edge) const;
+
     /**
      * Sets the values of all ghost cells depending on the specifed
      * boundary conditions;
@@ -170,6 +193,17 @@ namespace Blocks {
      */
     void setGhostLayer();
 
+    /// Replaces the ghost cells at edge with the cells of a neighbouring block
+    /**
+     * Copies all haloWidth layers of h, hu, hv and b next to the common edge, incl. the ghost cells of the
+     * neighbour along that edge, so both blocks need the same size along it and the same halo width. Call it
+     * after setGhostLayer of both blocks, the boundary type of the edge is only used for the values that are
+     * replaced. Exchanging the left and right edges of all blocks first fills the corners with the cells of
+     * diagonal neighbours. Blocks::DimensionalSplittingBlock::simulateHaloSteps can then run haloWidth steps
+     * before the next exchange.
+     */
+    void copyHalo(BoundaryEdge edge, const Block& neighbour);
+
     /**
      * Computes the largest allowed time step for the current grid block
      * (reference implementation) depending on the current values of
@@ -187,6 +221,13 @@ namespace Blocks {
     /// Executes a single time step (with fixed time step size) of the simulation
     virtual void simulateTimeStep(RealType dt);
 
+    /// Executes several time steps with the same size, each after setting the ghost layer
+    /**
+     * Derived classes can compute the steps in fewer passes over the grid, see
+     * Blocks::DimensionalSplittingBlock::simulateTimeSteps.
+     */
+    virtual void simulateTimeSteps(RealType dt, int steps);
+
     /// Performs the simulation starting with simulation time tStart, until simulation time tEnd is reached
     /**
      * Implements the main simulation loop between two checkpoints;
@@ -221,12 +262,21 @@ namespace Blocks {
 
     virtual bool hasError() = 0;
 
+    /// Returns the memory held by the arrays of the block in bytes
+    virtual size_t getMemoryUsage() const;
+
     // Access methods to grid sizes
     /// Returns #nx, i.e. the grid size in x-direction
     int getNx() const;
     /// Returns #ny, i.e. the grid size in y-direction
     int getNy() const;
 
+    /// Returns the number of ghost cell layers on each side
+    int getHaloWidth() const;
+
+    /// Returns true if the arrays are stored in a file
+    bool hasFileStorage() const;
+
     /// Returns #dx, i.e. the mesh size in x-direction
     RealType getDx() const;
     /// Returns #dy, i.e. the mesh size in y-direction
@@ -1,50 +1,115 @@
 #include "DimensionalSplitting.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Core/Parallel.hpp"
+#include "Core/PerfCounters.hpp"
+#include "Core/Profiler.hpp"
+#include "Core/Trace.hpp"
 
 namespace Blocks {
 
-  DimensionalSplittingBlock::DimensionalSplittingBlock(int nx, int ny, RealType dx, RealType dy):
-    Block(nx, ny, dx, dy),
-    hNetUpdatesLeft_(ny + 2, nx + 1),
-    hNetUpdatesRight_(ny + 2, nx + 1),
-    huNetUpdatesLeft_(ny + 2, nx + 1),
-    huNetUpdatesRight_(ny + 2, nx + 1) {}
+  // Rows of a chunk of the parallel sweeps, small grids run on one thread
+  static int getMinRowsPerChunk(int nx) { return std::max(1, 16384 / (nx + 1)); }
+
+  DimensionalSplittingBlock::DimensionalSplittingBlock(int nx, int ny, RealType dx, RealType dy, int haloWidth, const std::string& storagePath):
+    Block(nx, ny, dx, dy, haloWidth, storagePath) {
+
+    // Net updates of the whole grid would need as much memory as the file, simulateTimeSteps does without them
+    setDenseNetUpdates(!hasFileStorage());
+  }
+
+  void DimensionalSplittingBlock::computeNumericalFluxes() { computeNumericalFluxes(0); }
+
+  void DimensionalSplittingBlock::updateUnknowns(RealType dt) { updateUnknowns(dt, 0); }
+
+  void DimensionalSplittingBlock::simulateTimeStep(RealType dt) {
+    if (hasFileStorage()) {
+      simulateTimeSteps(dt, 1);
+    } else {
+      Block::simulateTimeStep(dt);
+    }
+  }
+
+  void DimensionalSplittingBlock::simulateHaloSteps(RealType dt, int steps) {
+    SWE_TRACE_ZONE("Halo Steps");
+
+    assert(steps <= haloWidth_);
+
+    for (int step = 0; step < steps; step++) {
+      int margin = steps - 1 - step;
+      computeNumericalFluxes(margin);
+      updateUnknowns(dt, margin);
+    }
+  }
 
-  void DimensionalSplittingBlock::computeNumericalFluxes() {
+  void DimensionalSplittingBlock::computeNumericalFluxes(int margin) {
     // X-Sweep:
+    SWE_PROFILE_SCOPE(XSweep);
+    SWE_PERF_SCOPE(XSweep);
+    SWE_TRACE_ZONE("X-Sweep");
+
+    assert(hNetUpdatesLeft_.getData() || !netUpdateBase_.empty()); // Not allocated with file storage
+
+    RealType   maxWaveSpeedX = RealType(0.0);
+    std::mutex maxMutex;
+
+    bool                       useTiles = sparse_ && margin == 0;
+    const std::vector<CellRun> fullRow  = {{1 - margin, nx_ + 1 + margin}};
+
+    // Loop over all vertical edges, edge x - 1 lies between cells x - 1 and x of a row
+    Core::parallelFor(
+      -margin,
+      ny_ + 2 + margin,
+      [&](int yBegin, int yEnd) {
+        std::vector<RealType> waveSpeeds(nx_ + 1 + 2 * margin);
+        CellTermBuffer        terms(nx_ + 2 + 2 * margin);
+        RealType              maxChunkSpeedX = RealType(0.0);
 
-    RealType maxWaveSpeedX = RealType(0.0);
-
-    // Loop over all vertical edges
-    for (int y = 0; y < ny_ + 2; y++) {
-      for (int x = 1; x < nx_ + 2; x++) {
-        RealType maxEdgeSpeedX = RealType(0.0);
-
-        // Compute net updates
-        solver_.computeNetUpdates(
-          h_[y][x - 1],
-          h_[y][x],
-          hu_[y][x - 1],
-          hu_[y][x],
-          b_[y][x - 1],
-          b_[y][x],
-          hNetUpdatesLeft_[y][x - 1],
-          hNetUpdatesRight_[y][x - 1],
-          huNetUpdatesLeft_[y][x - 1],
-          huNetUpdatesRight_[y][x - 1],
-          maxEdgeSpeedX
-        );
-
-        // Update maxWaveSpeed
-        if (maxEdgeSpeedX > maxWaveSpeedX) {
-          maxWaveSpeedX = maxEdgeSpeedX;
+        for (int y = yBegin; y < yEnd; y++) {
+          for (const CellRun& run : getCellRuns(y, useTiles, fullRow)) {
+            // Every cell of the run borders two edges, its terms are computed once for both
+            int          first = run.begin - 1; // Edge left of the first cell
+            NetUpdateRow net   = getNetUpdates(y, run.begin);
+            computeCellTerms(run.end - first + 1, hu_, first, y, terms, 0);
+
+            RealType maxRowSpeedX = computeNetUpdatesRow(
+              run.end - first,
+              hu_,
+              first,
+              y,
+              first + 1,
+              y,
+              terms.getTerms(0),
+              terms.getTerms(1),
+              net.hLeft - 1,
+              net.hRight - 1,
+              net.huLeft - 1,
+              net.huRight - 1,
+              waveSpeeds.data()
+            );
+
+            // Update maxWaveSpeed
+            if (maxRowSpeedX > maxChunkSpeedX) {
+              maxChunkSpeedX = maxRowSpeedX;
+            }
+          }
         }
-      }
-    }
+
+        std::lock_guard lock(maxMutex);
+        maxWaveSpeedX = std::max(maxWaveSpeedX, maxChunkSpeedX);
+      },
+      getMinRowsPerChunk(nx_)
+    );
 
     assert(maxWaveSpeedX > RealType(0.0));
 
@@ -52,56 +117,456 @@ namespace Blocks {
     maxTimeStep_ = dx_ / maxWaveSpeedX * RealType(0.4);
   }
 
-  void DimensionalSplittingBlock::updateUnknowns(RealType dt) {
+  void DimensionalSplittingBlock::updateUnknowns(RealType dt, int margin) {
+    assert(hNetUpdatesLeft_.getData() || !netUpdateBase_.empty()); // Not allocated with file storage
+
+    bool                       useTiles = sparse_ && margin == 0;
+    const std::vector<CellRun> fullRow  = {{1 - margin, nx_ + 1 + margin}};
+
+    {
+      SWE_PROFILE_SCOPE(XSweep);
+      SWE_PERF_SCOPE(XSweep);
+      SWE_TRACE_ZONE("X-Update");
+
+      // Loop over all inner cells
+      Core::parallelFor(
+        -margin,
+        ny_ + 2 + margin,
+        [&](int yBegin, int yEnd) {
+          for (int y = yBegin; y < yEnd; y++) {
+            for (const CellRun& run : getCellRuns(y, useTiles, fullRow)) {
+              NetUpdateRow net = getNetUpdates(y, run.begin);
+              for (int x = run.begin; x < run.end; x++) {
+                int i = x - run.begin;
+                h_[y][x] -= dt / dx_ * (net.hRight[i - 1] + net.hLeft[i]);
+                hu_[y][x] -= dt / dx_ * (net.huRight[i - 1] + net.huLeft[i]);
+              }
+            }
+          }
+        },
+        getMinRowsPerChunk(nx_)
+      );
+    }
+
+    // Y-Sweep:
+    SWE_PROFILE_SCOPE(YSweep);
+    SWE_PERF_SCOPE(YSweep);
+    SWE_TRACE_ZONE("Y-Sweep");
+
+    RealType   maxWaveSpeedY = RealType(0.0);
+    std::mutex maxMutex;
+
+    // Loop over horizontal edges, the edges between two rows are contiguous in x
+    Core::parallelFor(
+      1 - margin,
+      ny_ + 2 + margin,
+      [&](int yBegin, int yEnd) {
+        std::vector<RealType> waveSpeeds(nx_ + 2 * margin);
+        RealType              maxChunkSpeedY = RealType(0.0);
+
+        // Terms of the cells of rows y - 1 and y at index x + margin, a row is computed once for the edges below
+        // and above it. Only the cells of wet tiles are needed, an edge never uses the terms of a dry cell.
+        CellTermBuffer termsBelow(nx_ + 2 + 2 * margin);
+        CellTermBuffer termsAbove(nx_ + 2 + 2 * margin);
+        for (const CellRun& run : getCellRuns(yBegin - 1, useTiles, fullRow)) {
+          computeCellTerms(run.end - run.begin, hv_, run.begin, yBegin - 1, termsBelow, run.begin + margin);
+        }
+
+        for (int y = yBegin; y < yEnd; y++) {
+          for (const CellRun& run : getCellRuns(y, useTiles, fullRow)) {
+            computeCellTerms(run.end - run.begin, hv_, run.begin, y, termsAbove, run.begin + margin);
+          }
+
+          for (const CellRun& run : getEdgeRuns(y, useTiles, fullRow)) {
+            NetUpdateRow net          = getNetUpdates(y - 1, run.begin);
+            RealType     maxRowSpeedY = computeNetUpdatesRow(
+              run.end - run.begin,
+              hv_,
+              run.begin,
+              y - 1,
+              run.begin,
+              y,
+              termsBelow.getTerms(run.begin + margin),
+              termsAbove.getTerms(run.begin + margin),
+              net.hLeft,
+              net.hRight,
+              net.huLeft,  // reuse huNetUpdatesLeft_ as hvNetUpdatesLeft_
+              net.huRight, // reuse huNetUpdatesRight_ as hvNetUpdatesRight_
+              waveSpeeds.data()
+            );
+
+            // Update maxWaveSpeed
+            if (maxRowSpeedY > maxChunkSpeedY) {
+              maxChunkSpeedY = maxRowSpeedY;
+            }
+          }
+          std::swap(termsBelow, termsAbove);
+        }
+
+        std::lock_guard lock(maxMutex);
+        maxWaveSpeedY = std::max(maxWaveSpeedY, maxChunkSpeedY);
+      },
+      getMinRowsPerChunk(nx_)
+    );
+
+    if (dt >= RealType(0.5) * dy_ / maxWaveSpeedY) {
+      std::cerr << "Warning: CFL condition violated" << std::endl;
+    }
+
     // Loop over all inner cells
-    for (int y = 0; y < ny_ + 2; y++) {
-      for (int x = 1; x < nx_ + 1; x++) {
-        h_[y][x] -= dt / dx_ * (hNetUpdatesRight_[y][x - 1] + hNetUpdatesLeft_[y][x]);
-        hu_[y][x] -= dt / dx_ * (huNetUpdatesRight_[y][x - 1] + huNetUpdatesLeft_[y][x]);
+    Core::parallelFor(
+      1 - margin,
+      ny_ + 1 + margin,
+      [&](int yBegin, int yEnd) {
+        for (int y = yBegin; y < yEnd; y++) {
+          for (const CellRun& run : getCellRuns(y, useTiles, fullRow)) {
+            NetUpdateRow below = getNetUpdates(y - 1, run.begin);
+            NetUpdateRow above = getNetUpdates(y, run.begin);
+            for (int x = run.begin; x < run.end; x++) {
+              int i = x - run.begin;
+              h_[y][x] -= dt / dy_ * (below.hRight[i] + above.hLeft[i]);
+              hv_[y][x] -= dt / dy_ * (below.huRight[i] + above.huLeft[i]);
+            }
+          }
+        }
+      },
+      getMinRowsPerChunk(nx_)
+    );
+  }
+
+  void DimensionalSplittingBlock::setSparseTiles(bool enabled) {
+    SWE_TRACE_ZONE("Sparse Tiles");
+
+    sparse_ = enabled;
+    tileRowRuns_.clear();
+    tileEdgeRuns_.clear();
+    sparseNetUpdates_ = std::vector<RealType>();
+    netUpdateBase_    = std::vector<ptrdiff_t>();
+
+    int tilesX   = (nx_ + TileSize - 1) / TileSize;
+    int tilesY   = (ny_ + TileSize - 1) / TileSize;
+    tileCount_   = tilesX * tilesY;
+    activeTiles_ = tileCount_;
+    if (!enabled) {
+      setDenseNetUpdates(!hasFileStorage());
+      return;
+    }
+
+    // A tile is wet if any of its cells is below sea level
+    std::vector<uint8_t> wet(tileCount_);
+    Core::parallelFor(0, tilesY, [&](int tyBegin, int tyEnd) {
+      for (int ty = tyBegin; ty < tyEnd; ty++) {
+        for (int y = ty * TileSize + 1; y <= std::min(ny_, (ty + 1) * TileSize); y++) {
+          for (int x = 1; x <= nx_; x++) {
+            if (!(b_[y][x] > RealType(0.0))) {
+              wet[size_t(ty) * tilesX + (x - 1) / TileSize] = 1;
+            }
+          }
+        }
       }
+    });
+
+    // Consecutive wet tiles (of either row, to get the union for the edges in between) form one run
+    auto getRuns = [&](int tyA, int tyB) {
+      std::vector<CellRun> runs;
+      for (int tx = 0; tx < tilesX; tx++) {
+        if (!wet[size_t(tyA) * tilesX + tx] && !wet[size_t(tyB) * tilesX + tx]) {
+          continue;
+        }
+        int begin = tx * TileSize + 1;
+        int end   = std::min(nx_, (tx + 1) * TileSize) + 1;
+        if (!runs.empty() && runs.back().end == begin) {
+          runs.back().end = end;
+        } else {
+          runs.push_back({begin, end});
+        }
+      }
+      return runs;
+    };
+
+    for (int ty = 0; ty < tilesY; ty++) {
+      tileRowRuns_.push_back(getRuns(ty, ty));
+      tileEdgeRuns_.push_back(ty > 0 ? getRuns(ty - 1, ty) : std::vector<CellRun>());
     }
+    activeTiles_ = int(std::count(wet.begin(), wet.end(), uint8_t(1)));
 
-    // Y-Sweep:
+    // The halo steps of a wider halo sweep the ghost layers without tiles, they need the full arrays
+    if (haloWidth_ > 1 || hasFileStorage()) {
+      setDenseNetUpdates(!hasFileStorage());
+      return;
+    }
 
-    RealType maxWaveSpeedY = RealType(0.0);
-
-    // Loop over horizontal edges
-    for (int y = 1; y < ny_ + 2; y++) {
-      for (int x = 1; x < nx_ + 1; x++) {
-        RealType maxEdgeSpeedY = RealType(0.0);
-
-        // Compute net updates
-        solver_.computeNetUpdates(
-          h_[y - 1][x],
-          h_[y][x],
-          hv_[y - 1][x],
-          hv_[y][x],
-          b_[y - 1][x],
-          b_[y][x],
-          hNetUpdatesLeft_[y - 1][x],
-          hNetUpdatesRight_[y - 1][x],
-          huNetUpdatesLeft_[y - 1][x],  // reuse huNetUpdatesLeft_ as hvNetUpdatesLeft_
-          huNetUpdatesRight_[y - 1][x], // reuse huNetUpdatesRight_ as hvNetUpdatesRight_
-          maxEdgeSpeedY
-        );
-
-        // Update maxWaveSpeed
-        if (maxEdgeSpeedY > maxWaveSpeedY) {
-          maxWaveSpeedY = maxEdgeSpeedY;
+    // Row y holds the edges of the sweeps of its cells and of the edges to row y + 1, whose runs contain its cells
+    size_t count = 0;
+    netUpdateBase_.resize(size_t(ny_ + 2) * tilesX);
+    for (int y = 0; y <= ny_ + 1; y++) {
+      for (const CellRun& run : getEdgeRuns(y + 1, true, {})) {
+        for (int tx = (run.begin - 1) / TileSize; tx <= (run.end - 2) / TileSize; tx++) {
+          netUpdateBase_[size_t(y) * tilesX + tx] = ptrdiff_t(count) + 1 - run.begin; // The edge left of the run comes first
         }
+        count += run.end - run.begin + 1;
       }
     }
 
-    if (dt >= RealType(0.5) * dy_ / maxWaveSpeedY) {
+    setDenseNetUpdates(false);
+    sparseNetUpdates_.resize(4 * count);
+  }
+
+  float DimensionalSplittingBlock::getActiveTileFraction() const { return tileCount_ > 0 ? float(activeTiles_) / float(tileCount_) : 1.0f; }
+
+  int DimensionalSplittingBlock::getTileRow(int y) const { return std::clamp((y - 1) / TileSize, 0, int(tileRowRuns_.size()) - 1); }
+
+  const std::vector<DimensionalSplittingBlock::CellRun>& DimensionalSplittingBlock::getCellRuns(int y, bool useTiles, const std::vector<CellRun>& fullRow) const {
+    return useTiles ? tileRowRuns_[getTileRow(y)] : fullRow;
+  }
+
+  const std::vector<DimensionalSplittingBlock::CellRun>& DimensionalSplittingBlock::getEdgeRuns(int y, bool useTiles, const std::vector<CellRun>& fullRow) const {
+    if (!useTiles) {
+      return fullRow;
+    }
+    int below = getTileRow(y - 1);
+    int above = getTileRow(y);
+    return below == above ? tileRowRuns_[above] : tileEdgeRuns_[above];
+  }
+
+  DimensionalSplittingBlock::NetUpdateRow DimensionalSplittingBlock::getNetUpdates(int y, int x) {
+    if (!netUpdateBase_.empty()) {
+      int       tilesX = (nx_ + TileSize - 1) / TileSize;
+      size_t    count  = sparseNetUpdates_.size() / 4;
+      RealType* first  = sparseNetUpdates_.data() + (netUpdateBase_[size_t(y) * tilesX + (x - 1) / TileSize] + x);
+      return {first, first + count, first + 2 * count, first + 3 * count};
+    }
+    return {hNetUpdatesLeft_[y] + x, hNetUpdatesRight_[y] + x, huNetUpdatesLeft_[y] + x, huNetUpdatesRight_[y] + x};
+  }
+
+  void DimensionalSplittingBlock::setDenseNetUpdates(bool enabled) {
+    if (!enabled) {
+      hNetUpdatesLeft_   = Float2D<RealType>();
+      hNetUpdatesRight_  = Float2D<RealType>();
+      huNetUpdatesLeft_  = Float2D<RealType>();
+      huNetUpdatesRight_ = Float2D<RealType>();
+    } else if (!hNetUpdatesLeft_.getData()) {
+      hNetUpdatesLeft_   = Float2D<RealType>(ny_ + 2, nx_ + 1, haloWidth_ - 1);
+      hNetUpdatesRight_  = Float2D<RealType>(ny_ + 2, nx_ + 1, haloWidth_ - 1);
+      huNetUpdatesLeft_  = Float2D<RealType>(ny_ + 2, nx_ + 1, haloWidth_ - 1);
+      huNetUpdatesRight_ = Float2D<RealType>(ny_ + 2, nx_ + 1, haloWidth_ - 1);
+    }
+  }
+
+  // Rows used by one step: net updates of one row in x-direction and of two rows of edges in y-direction, and the
+  // cell terms of one row in x-direction and of two rows of inner cells in y-direction
+  struct DimensionalSplittingBlock::RowScratch {
+    explicit RowScratch(int nx):
+      hLeftX(nx + 1),
+      hRightX(nx + 1),
+      huLeftX(nx + 1),
+      huRightX(nx + 1),
+      waveSpeeds(nx + 1),
+      hLeftY{std::vector<RealType>(nx), std::vector<RealType>(nx)},
+      hRightY{std::vector<RealType>(nx), std::vector<RealType>(nx)},
+      hvLeftY{std::vector<RealType>(nx), std::vector<RealType>(nx)},
+      hvRightY{std::vector<RealType>(nx), std::vector<RealType>(nx)},
+      termsX(nx + 2),
+      termsY{CellTermBuffer(nx), CellTermBuffer(nx)} {}
+
+    std::vector<RealType> hLeftX, hRightX, huLeftX, huRightX, waveSpeeds;
+    std::vector<RealType> hLeftY[2], hRightY[2], hvLeftY[2], hvRightY[2]; // Edges above row y are in slot y % 2
+    CellTermBuffer        termsX;
+    CellTermBuffer        termsY[2]; // Row y is in slot y % 2
+  };
+
+  void DimensionalSplittingBlock::simulateTimeSteps(RealType dt, int steps) {
+    SWE_PROFILE_SCOPE(BlockedSteps);
+    SWE_PERF_SCOPE(BlockedSteps);
+    SWE_TRACE_ZONE("Blocked Steps");
+
+    if (steps <= 0) {
+      return;
+    }
+
+    // Last stage of every step that is done, stage y sweeps row y + 1 in x-direction and updates row y
+    std::vector<std::atomic<int>> progress(steps);
+    for (auto& stage : progress) {
+      stage.store(-2, std::memory_order_relaxed);
+    }
+
+    // Chunks take the next steps when they start, so a chunk only waits for chunks that are running already
+    std::atomic<int> nextStep = 0;
+
+    // Rows of a band of file storage, the first one is loaded before the pass
+    int bandRows = std::max(16, int((size_t(4) << 20) / (sizeof(RealType) * size_t(nx_ + 2))));
+    if (hasFileStorage()) {
+      prefetchRows(0, bandRows);
+    }
+
+    RealType   maxWaveSpeedX = RealType(0.0);
+    RealType   maxWaveSpeedY = RealType(0.0);
+    std::mutex maxMutex;
+
+    Core::parallelFor(0, steps, [&](int begin, int end) {
+      int                     stepBegin = nextStep.fetch_add(end - begin);
+      int                     stepEnd   = stepBegin + end - begin;
+      std::vector<RowScratch> scratch(stepEnd - stepBegin, RowScratch(nx_));
+      RealType                maxGroupSpeedX = RealType(0.0);
+      RealType                maxGroupSpeedY = RealType(0.0);
+
+      // Stage y of step s runs after stage y + 2 of step s - 1, which has finished the rows it reads and writes
+      int lastStage = ny_ + 2 * (stepEnd - 1 - stepBegin);
+      for (int wave = -1; wave <= lastStage; wave++) {
+        for (int s = stepBegin; s < stepEnd; s++) {
+          int y = wave - 2 * (s - stepBegin);
+          if (y < -1 || y > ny_) {
+            continue;
+          }
+
+          if (s == stepBegin && s > 0) {
+            // The previous step belongs to another group
+            int needed = std::min(y + 2, ny_);
+            int done   = progress[s - 1].load(std::memory_order_acquire);
+            while (done < needed) {
+              progress[s - 1].wait(done, std::memory_order_acquire);
+              done = progress[s - 1].load(std::memory_order_acquire);
+            }
+          }
+
+          // Row y + 1 starts the step, the top ghost row is copied before row ny changes
+          int row = y + 1;
+          if (s == 0 && row % bandRows == 0 && hasFileStorage()) {
+            prefetchRows(row + bandRows, row + 2 * bandRows);
+          }
+          if (row == ny_) {
+            setGhostCells(ny_ + 1);
+          }
+          if (row <= ny_) {
+            setGhostCells(row);
+          }
+          maxGroupSpeedX = std::max(maxGroupSpeedX, sweepRowX(row, dt, scratch[s - stepBegin]));
+
+          if (y >= 0) {
+            maxGroupSpeedY = std::max(maxGroupSpeedY, sweepEdgesY(y, scratch[s - stepBegin], y % 2));
+          }
+          if (y >= 1 && y <= ny_) {
+            updateRowY(y, dt, scratch[s - stepBegin], (y - 1) % 2, y % 2);
+          }
+
+          if (s == stepEnd - 1 && stepEnd < steps) {
+            progress[s].store(y, std::memory_order_release);
+            progress[s].notify_all();
+          }
+
+          // Rows up to y are final, no step reads them anymore
+          if (s == steps - 1 && (y + 1) % bandRows == 0 && y >= 0 && hasFileStorage()) {
+            releaseRows(y + 1 - bandRows, y + 1);
+          }
+        }
+      }
+
+      std::lock_guard lock(maxMutex);
+      maxWaveSpeedX = std::max(maxWaveSpeedX, maxGroupSpeedX);
+      maxWaveSpeedY = std::max(maxWaveSpeedY, maxGroupSpeedY);
+    });
+
+    if (hasFileStorage()) {
+      releaseRows((ny_ + 1) / bandRows * bandRows, ny_ + 2);
+    }
+
+    assert(maxWaveSpeedX > RealType(0.0) && maxWaveSpeedY > RealType(0.0));
+
+    if (dt >= RealType(0.5) * dx_ / maxWaveSpeedX || dt >= RealType(0.5) * dy_ / maxWaveSpeedY) {
       std::cerr << "Warning: CFL condition violated" << std::endl;
     }
 
-    // Loop over all inner cells
-    for (int y = 1; y < ny_ + 1; y++) {
-      for (int x = 1; x < nx_ + 1; x++) {
-        h_[y][x] -= dt / dy_ * (hNetUpdatesRight_[y - 1][x] + hNetUpdatesLeft_[y][x]);
-        hv_[y][x] -= dt / dy_ * (huNetUpdatesRight_[y - 1][x] + huNetUpdatesLeft_[y][x]);
+    maxTimeStep_ = std::min(dx_ / maxWaveSpeedX, dy_ / maxWaveSpeedY) * RealType(0.4);
+  }
+
+  void DimensionalSplittingBlock::setGhostCells(int y) {
+    if (y == 0 || y == ny_ + 1) {
+      BoundaryEdge edge  = y == 0 ? BoundaryEdge::Bottom : BoundaryEdge::Top;
+      int          inner = y == 0 ? 1 : ny_;
+      RealType     sign  = boundary_[edge] == BoundaryType::Wall ? RealType(-1.0) : RealType(1.0);
+
+      for (int x = 1; x <= nx_; x++) {
+        h_[y][x]  = h_[inner][x];
+        hu_[y][x] = hu_[inner][x];
+        hv_[y][x] = sign * hv_[inner][x];
+      }
+
+      // Corners get the values of the diagonal neighbours
+      for (int x : {0, nx_ + 1}) {
+        int innerX   = x == 0 ? 1 : nx_;
+        h_[y][x]     = h_[inner][innerX];
+        hu_[y][x]    = hu_[inner][innerX];
+        hv_[y][x]    = hv_[inner][innerX];
       }
+      return;
+    }
+
+    RealType signLeft  = boundary_[BoundaryEdge::Left] == BoundaryType::Wall ? RealType(-1.0) : RealType(1.0);
+    RealType signRight = boundary_[BoundaryEdge::Right] == BoundaryType::Wall ? RealType(-1.0) : RealType(1.0);
+
+    h_[y][0]  = h_[y][1];
+    hu_[y][0] = signLeft * hu_[y][1];
+    hv_[y][0] = hv_[y][1];
+
+    h_[y][nx_ + 1]  = h_[y][nx_];
+    hu_[y][nx_ + 1] = signRight * hu_[y][nx_];
+    hv_[y][nx_ + 1] = hv_[y][nx_];
+  }
+
+  RealType DimensionalSplittingBlock::sweepRowX(int y, RealType dt, RowScratch& scratch) {
+    computeCellTerms(nx_ + 2, hu_, 0, y, scratch.termsX, 0);
+
+    RealType maxWaveSpeed = computeNetUpdatesRow(
+      nx_ + 1,
+      hu_,
+      0,
+      y,
+      1,
+      y,
+      scratch.termsX.getTerms(0),
+      scratch.termsX.getTerms(1),
+      scratch.hLeftX.data(),
+      scratch.hRightX.data(),
+      scratch.huLeftX.data(),
+      scratch.huRightX.data(),
+      scratch.waveSpeeds.data()
+    );
+
+    for (int x = 1; x < nx_ + 1; x++) {
+      h_[y][x] -= dt / dx_ * (scratch.hRightX[x - 1] + scratch.hLeftX[x]);
+      hu_[y][x] -= dt / dx_ * (scratch.huRightX[x - 1] + scratch.huLeftX[x]);
+    }
+    return maxWaveSpeed;
+  }
+
+  RealType DimensionalSplittingBlock::sweepEdgesY(int y, RowScratch& scratch, int slot) {
+    // Row y is left from the edges below it (it has not changed since), only the first step computes it here
+    if (y == 0) {
+      computeCellTerms(nx_, hv_, 1, 0, scratch.termsY[0], 0);
+    }
+    computeCellTerms(nx_, hv_, 1, y + 1, scratch.termsY[(y + 1) % 2], 0);
+
+    return computeNetUpdatesRow(
+      nx_,
+      hv_,
+      1,
+      y,
+      1,
+      y + 1,
+      scratch.termsY[y % 2].getTerms(0),
+      scratch.termsY[(y + 1) % 2].getTerms(0),
+      scratch.hLeftY[slot].data(),
+      scratch.hRightY[slot].data(),
+      scratch.hvLeftY[slot].data(),
+      scratch.hvRightY[slot].data(),
+      scratch.waveSpeeds.data()
+    );
+  }
+
+  void DimensionalSplittingBlock::updateRowY(int y, RealType dt, const RowScratch& scratch, int slotBelow, int slotAbove) {
+    for (int x = 1; x < nx_ + 1; x++) {
+      h_[y][x] -= dt / dy_ * (scratch.hRightY[slotBelow][x - 1] + scratch.hLeftY[slotAbove][x - 1]);
+      hv_[y][x] -= dt / dy_ * (scratch.hvRightY[slotBelow][x - 1] + scratch.hvLeftY[slotAbove][x - 1]);
     }
   }
 
@@ -111,4 +576,115 @@ namespace Blocks {
     return e;
   }
 
+  void DimensionalSplittingBlock::computeCellTerms(int n, const Float2D<RealType>& momentum, int x, int y, CellTermBuffer& o_buffer, int i) {
+    solver_.computeCellTerms(n, h_[y] + x, momentum[y] + x, o_buffer.sqrtH.data() + i, o_buffer.celerity.data() + i, o_buffer.velocity.data() + i);
+  }
+
+  RealType DimensionalSplittingBlock::computeNetUpdatesRow(
+    int                      n,
+    const Float2D<RealType>& momentum,
+    int                      xLeft,
+    int                      yLeft,
+    int                      xRight,
+    int                      yRight,
+    const CellTerms&         termsLeft,
+    const CellTerms&         termsRight,
+    RealType*                o_hUpdateLeft,
+    RealType*                o_hUpdateRight,
+    RealType*                o_huUpdateLeft,
+    RealType*                o_huUpdateRight,
+    RealType*                o_waveSpeeds
+  ) {
+
+    const RealType* hLeft   = h_[yLeft] + xLeft;
+    const RealType* hRight  = h_[yRight] + xRight;
+    const RealType* huLeft  = momentum[yLeft] + xLeft;
+    const RealType* huRight = momentum[yRight] + xRight;
+
+    switch (bathymetryFormat_) {
+    case CompactFormat::Half:
+      return solver_.computeNetUpdatesRow(
+        n,
+        CompactBathymetryRow<HalfFormat>{hLeft, huLeft, compactB_[yLeft] + xLeft},
+        CompactBathymetryRow<HalfFormat>{hRight, huRight, compactB_[yRight] + xRight},
+        termsLeft,
+        termsRight,
+        o_hUpdateLeft,
+        o_hUpdateRight,
+        o_huUpdateLeft,
+        o_huUpdateRight,
+        o_waveSpeeds
+      );
+    case CompactFormat::BFloat16:
+      return solver_.computeNetUpdatesRow(
+        n,
+        CompactBathymetryRow<BFloat16Format>{hLeft, huLeft, compactB_[yLeft] + xLeft},
+        CompactBathymetryRow<BFloat16Format>{hRight, huRight, compactB_[yRight] + xRight},
+        termsLeft,
+        termsRight,
+        o_hUpdateLeft,
+        o_hUpdateRight,
+        o_huUpdateLeft,
+        o_huUpdateRight,
+        o_waveSpeeds
+      );
+    default:
+      return solver_.computeNetUpdatesRow(
+        n,
+        SoALayout::Row{hLeft, huLeft, b_[yLeft] + xLeft},
+        SoALayout::Row{hRight, huRight, b_[yRight] + xRight},
+        termsLeft,
+        termsRight,
+        o_hUpdateLeft,
+        o_hUpdateRight,
+        o_huUpdateLeft,
+        o_huUpdateRight,
+        o_waveSpeeds
+      );
+    }
+  }
+
+  // Rounds the bathymetry (incl. all ghost layers) to Format, the wet cells keep their sea surface
+  template <class Format>
+  static void compactBathymetry(Float2D<RealType>& b, Float2D<RealType>& h, Float2D<uint16_t>& compact) {
+    int halo = b.getHalo();
+    Core::parallelFor(-halo, b.getCols() + halo, [&](int yBegin, int yEnd) {
+      for (int y = yBegin; y < yEnd; y++) {
+        for (int x = -halo; x < b.getRows() + halo; x++) {
+          uint16_t bits    = Format::encode(b[y][x]);
+          RealType rounded = RealType(Format::decode(bits));
+          if (!(rounded > RealType(0.0))) {
+            h[y][x] += b[y][x] - rounded;
+          }
+          b[y][x]       = rounded;
+          compact[y][x] = bits;
+        }
+      }
+    });
+  }
+
+  void DimensionalSplittingBlock::setBathymetryFormat(CompactFormat format) {
+    SWE_TRACE_ZONE("Compact Bathymetry");
+
+    bathymetryFormat_ = format;
+    if (format == CompactFormat::Full) {
+      compactB_ = Float2D<uint16_t>();
+      return;
+    }
+
+    compactB_ = Float2D<uint16_t>(ny_ + 2, nx_ + 2, haloWidth_ - 1);
+    if (format == CompactFormat::Half) {
+      compactBathymetry<HalfFormat>(b_, h_, compactB_);
+    } else {
+      compactBathymetry<BFloat16Format>(b_, h_, compactB_);
+    }
+  }
+
+  CompactFormat DimensionalSplittingBlock::getBathymetryFormat() const { return bathymetryFormat_; }
+
+  size_t DimensionalSplittingBlock::getMemoryUsage() const {
+    size_t netUpdates = 4 * sizeof(RealType) * hNetUpdatesLeft_.getAllocatedSize() + sizeof(RealType) * sparseNetUpdates_.size() + sizeof(ptrdiff_t) * netUpdateBase_.size();
+    return Block::getMemoryUsage() + netUpdates + sizeof(uint16_t) * compactB_.getAllocatedSize();
+  }
+
 } // namespace Blocks
@@ -5,8 +5,13 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "Blocks/Block.hpp"
 #include "Solvers/Fwave.hpp"
+#include "Types/CompactFloat.hpp"
 #include "Types/Float2D.hpp"
 
 namespace Blocks {
@@ -25,8 +30,12 @@ namespace Blocks {
      * @param ny Number of cells in y-direction
      * @param dx Cell size in x-direction
      * @param dy Cell size in y-direction
+     * @param haloWidth Number of ghost cell layers, see simulateHaloSteps
+     * @param storagePath File for the unknowns and bathymetry of grids larger than the main memory, see
+     *                    Blocks::Block::Block. Such blocks have no net update arrays and only step with
+     *                    simulateTimeStep and simulateTimeSteps, which stream the rows through memory in bands.
      */
-    DimensionalSplittingBlock(int nx, int ny, RealType dx, RealType dy);
+    DimensionalSplittingBlock(int nx, int ny, RealType dx, RealType dy, int haloWidth = 1, const std::string& storagePath = std::string());
 
     DimensionalSplittingBlock(const DimensionalSplittingBlock&) = delete;
 
@@ -41,9 +50,164 @@ namespace Blocks {
      */
     void updateUnknowns(RealType dt) override;
 
+    /// Executes a time step with computeNumericalFluxes and updateUnknowns, or as a single pass with file storage
+    void simulateTimeStep(RealType dt) override;
+
+    /**
+     * @brief Execute several time steps of size dt with temporal blocking
+     *
+     * The steps are computed in one pass over the grid: step s works on row y while step s + 1 works on
+     * row y - 2, so the rows of all steps in flight stay in the cache and every row is read from memory about
+     * once per call instead of several times per step. The results are the same as for separate steps with
+     * setGhostLayer, computeNumericalFluxes and updateUnknowns(dt). The steps are split into groups that run on
+     * different threads, each following the one before.
+     *
+     * About 2 * steps + 3 rows are in use at a time, which should fit in the last level cache. As dt cannot
+     * change during the call, it should leave some room to the CFL condition (warns if it was violated).
+     * Afterwards getMaxTimeStep returns the time step allowed by the largest wave speed of all steps.
+     *
+     * With file storage the pass streams the rows in bands of a few MiB: the first step prefetches the band
+     * after the one it enters and the last step writes back and releases every band it leaves, so the kernel
+     * reads and writes the file while the steps compute and only a few bands stay resident.
+     */
+    void simulateTimeSteps(RealType dt, int steps) override;
+
+    /**
+     * @brief Execute up to haloWidth time steps of size dt with a single ghost layer update
+     *
+     * Step s also updates the outer ghost cell layers up to haloWidth - 1 - s, so the next step finds valid
+     * values in its ghost cells without setting them again. With the halo filled from neighbouring blocks
+     * (see Blocks::Block::copyHalo), a decomposed grid exchanges values once every haloWidth steps instead of
+     * every step, at the cost of computing the halo several times. Within a single block the evolved ghost
+     * cells only approximate the boundary conditions, which are applied once at the beginning.
+     */
+    void simulateHaloSteps(RealType dt, int steps);
+
+    /// Width and height of the tiles of setSparseTiles in cells
+    static constexpr int TileSize = 32;
+
+    /**
+     * @brief Skip the tiles that only contain dry land in the sweeps
+     *
+     * Cells with positive bathymetry are dry for the solver and never change, so the sweeps only visit the
+     * tiles with at least one wet cell. Edges between such a tile and a dry one are computed with the wet tile,
+     * edges between dry cells only have zero net updates. The results stay the same, the work of a step shrinks
+     * with the fraction of dry tiles.
+     *
+     * The net updates are then only stored for the rows of the wet tiles (see getMemoryUsage). The unknowns keep
+     * their full size, the app and the scenarios address them directly. Blocks with a halo wider than one layer
+     * keep the full net update arrays, as their halo steps sweep the ghost layers without tiles.
+     *
+     * The tiles are found from the bathymetry when enabling, call it again after the bathymetry changed.
+     * Only computeNumericalFluxes and updateUnknowns use the tiles.
+     */
+    void setSparseTiles(bool enabled);
+
+    /// Returns the fraction of the tiles that are swept (1 without sparse tiles)
+    float getActiveTileFraction() const;
+
+    /**
+     * @brief Let the sweeps read the bathymetry in 16 bits per cell (HalfFormat or BFloat16Format)
+     *
+     * The bathymetry incl. ghost cells is rounded away from zero, so dry cells stay dry and wet cells only get
+     * deeper. The rounded values replace the bathymetry of the block, so the app and the solver see the same one,
+     * and the water height of the wet cells grows by the difference. The sea surface stays where it was and a
+     * lake at rest stays at rest. The sweeps then read 2 bytes of bathymetry per cell instead of
+     * sizeof(RealType), decoding it in registers.
+     *
+     * The compact copy is a read-only mirror for the bandwidth of the sweeps, not a replacement: the bathymetry of
+     * the block keeps its full size for the ghost layers, the halo exchange, the app and file storage, so the block
+     * needs 2 bytes more per cell (see getMemoryUsage). There is no static edge data to compress, the sweeps
+     * compute every edge from the cells on either side and the bathymetry is their only static input.
+     *
+     * Call after initialiseScenario (and the first halo exchange). CompactFormat::Full drops the compact copy,
+     * the bathymetry keeps the rounded values.
+     */
+    void setBathymetryFormat(CompactFormat format);
+
+    CompactFormat getBathymetryFormat() const;
+
     bool hasError() override;
 
+    size_t getMemoryUsage() const override;
+
   private:
+    struct RowScratch;
+
+    /// Cells [begin, end) of a row
+    struct CellRun {
+      int begin;
+      int end;
+    };
+
+    /// Net updates of a row from a cell on: index i holds the edge right of cell i in x-direction (i = -1 the edge
+    /// left of the first cell) and the edge above cell i in y-direction
+    struct NetUpdateRow {
+      RealType* hLeft;
+      RealType* hRight;
+      RealType* huLeft;
+      RealType* huRight;
+    };
+
+    /// Terms of the cells of a row for the solver (see Solvers::Fwave::computeCellTerms)
+    struct CellTermBuffer {
+      explicit CellTermBuffer(int n):
+        sqrtH(n),
+        celerity(n),
+        velocity(n) {}
+
+      /// Terms from index i on
+      CellTerms getTerms(int i) const { return {sqrtH.data() + i, celerity.data() + i, velocity.data() + i}; }
+
+      std::vector<RealType> sqrtH, celerity, velocity;
+    };
+
+    /// Returns the row of tiles that contains row y, ghost rows belong to the first and last one
+    int getTileRow(int y) const;
+    /// Cells of row y that are swept, fullRow if the tiles are not used
+    const std::vector<CellRun>& getCellRuns(int y, bool useTiles, const std::vector<CellRun>& fullRow) const;
+    /// Edges between rows y - 1 and y that are swept (by their upper cell), fullRow if the tiles are not used
+    const std::vector<CellRun>& getEdgeRuns(int y, bool useTiles, const std::vector<CellRun>& fullRow) const;
+
+    /// Net updates of row y from cell x on, x has to be the first cell of a run of getCellRuns or getEdgeRuns
+    NetUpdateRow getNetUpdates(int y, int x);
+    /// Allocates the net update arrays of the whole grid, or frees them
+    void setDenseNetUpdates(bool enabled);
+
+    /// X-sweep (net updates) including margin ghost cell layers
+    void computeNumericalFluxes(int margin);
+    /// X-update and y-sweep including margin ghost cell layers
+    void updateUnknowns(RealType dt, int margin);
+
+    /// Sets the ghost cells of row y like Blocks::Block::setBoundaryConditions: the left and right ones of an inner
+    /// row, all of the bottom and top ghost rows (from rows 1 and ny)
+    void setGhostCells(int y);
+    /// X-sweep and x-update of row y, returns the maximum wave speed
+    RealType sweepRowX(int y, RealType dt, RowScratch& scratch);
+    /// Net updates of the edges between rows y and y + 1 (inner cells), returns the maximum wave speed
+    RealType sweepEdgesY(int y, RowScratch& scratch, int slot);
+    /// Y-update of row y from the net updates below (slotBelow) and above (slotAbove)
+    void updateRowY(int y, RealType dt, const RowScratch& scratch, int slotBelow, int slotAbove);
+
+    /// Terms of the n cells from (x, y) on, written to o_buffer from index i on
+    void computeCellTerms(int n, const Float2D<RealType>& momentum, int x, int y, CellTermBuffer& o_buffer, int i);
+    /// Net updates of the n edges between the cells from (xLeft, yLeft) and from (xRight, yRight) on, in the bathymetry format of the block
+    RealType computeNetUpdatesRow(
+      int                      n,
+      const Float2D<RealType>& momentum,
+      int                      xLeft,
+      int                      yLeft,
+      int                      xRight,
+      int                      yRight,
+      const CellTerms&         termsLeft,
+      const CellTerms&         termsRight,
+      RealType*                o_hUpdateLeft,
+      RealType*                o_hUpdateRight,
+      RealType*                o_huUpdateLeft,
+      RealType*                o_huUpdateRight,
+      RealType*                o_waveSpeeds
+    );
+
     /** @brief Net updates for water height (left-going waves) */
     Float2D<RealType> hNetUpdatesLeft_;
     /** @brief Net updates for water height (right-going waves) */
@@ -53,6 +217,21 @@ namespace Blocks {
     /** @brief Net updates for momentum in x/y-direction (right/up-going waves) */
     Float2D<RealType> huNetUpdatesRight_;
 
+    bool                              sparse_      = false;
+    int                               activeTiles_ = 0;
+    int                               tileCount_   = 0;
+    std::vector<std::vector<CellRun>> tileRowRuns_;  ///< Cells of the wet tiles per row of tiles
+    std::vector<std::vector<CellRun>> tileEdgeRuns_; ///< Union of the runs of row r - 1 and r of tiles, for r > 0
+
+    /// Net updates of the wet tiles instead of the four arrays above (four arrays of a quarter of the size each).
+    /// Row y stores the runs of getEdgeRuns(y + 1) and the edge left of each, cell x of row y is at index
+    /// netUpdateBase_[y * tilesX + tile of x] + x.
+    std::vector<RealType>  sparseNetUpdates_;
+    std::vector<ptrdiff_t> netUpdateBase_;
+
+    CompactFormat     bathymetryFormat_ = CompactFormat::Full;
+    Float2D<uint16_t> compactB_; ///< Read-only mirror of b_ in bathymetryFormat_ for the sweeps, the same shape
+
     /** @brief F-wave solver instance */
     Solvers::Fwave solver_;
   };
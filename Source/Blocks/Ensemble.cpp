@@ -0,0 +1,231 @@
+#include "Ensemble.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+#include "Core/Parallel.hpp"
+#include "Core/Trace.hpp"
+#include "DimensionalSplitting.hpp"
+
+namespace Blocks {
+
+  static constexpr RealType DryTolerance = RealType(0.1); // Same as for the time step, shallower cells do not count as flooded
+
+  /// Block that can start from the state of another one, sharing its bathymetry
+  class EnsembleMember: public DimensionalSplittingBlock {
+  public:
+    using DimensionalSplittingBlock::DimensionalSplittingBlock;
+
+    /// Removes the displacement from the sea surface, keeping it in the bathymetry
+    void extractDisplacement(Float2D<RealType>& displacement) {
+      Core::parallelFor(1, ny_ + 1, [&](int jBegin, int jEnd) {
+        for (int j = jBegin; j < jEnd; j++) {
+          for (int i = 1; i <= nx_; i++) {
+            RealType d                  = h_[j][i] > RealType(0.0) ? h_[j][i] + b_[j][i] : RealType(0.0);
+            displacement[j - 1][i - 1] = d;
+            h_[j][i]                    = std::max(h_[j][i] - d, RealType(0.0));
+          }
+        }
+      });
+    }
+
+    /// Copies the unknowns of base and uses its bathymetry, which has to stay unchanged while this block uses it
+    void initialiseFromBase(EnsembleMember& base) {
+      assert(nx_ == base.nx_ && ny_ == base.ny_);
+
+      offsetX_ = base.offsetX_;
+      offsetY_ = base.offsetY_;
+      std::copy(base.boundary_, base.boundary_ + 4, boundary_);
+
+      size_t bytes = sizeof(RealType) * size_t(h_.getRows()) * h_.getCols();
+      std::memcpy(h_.getData(), base.h_.getData(), bytes);
+      std::memcpy(hu_.getData(), base.hu_.getData(), bytes);
+      std::memcpy(hv_.getData(), base.hv_.getData(), bytes);
+
+      if (b_.getData() != base.b_.getData()) {
+        b_ = Float2D<RealType>(base.b_, true);
+      }
+    }
+
+    /// Raises the sea surface of the wet cells by the shifted and scaled displacement
+    void addDisplacement(const Float2D<RealType>& displacement, const EnsembleVariant& variant) {
+      int si = int(std::lround(variant.shiftX / dx_));
+      int sj = int(std::lround(variant.shiftY / dy_));
+
+      for (int j = 1; j <= ny_; j++) {
+        int dj = j - 1 - sj;
+        if (dj < 0 || dj >= ny_) {
+          continue;
+        }
+        for (int i = 1; i <= nx_; i++) {
+          int di = i - 1 - si;
+          if (di < 0 || di >= nx_ || h_[j][i] + displacement[j - 1][i - 1] <= RealType(0.0)) {
+            continue; // Outside of the displacement or dry land
+          }
+          h_[j][i] = std::max(h_[j][i] + variant.scale * displacement[dj][di], RealType(0.0));
+        }
+      }
+    }
+
+    void updateMaxSurface(Float2D<float>& maxSurface) const {
+      for (int j = 1; j <= ny_; j++) {
+        for (int i = 1; i <= nx_; i++) {
+          float surface = h_[j][i] > DryTolerance ? float(h_[j][i] + b_[j][i]) : -std::numeric_limits<float>::infinity();
+          maxSurface[j - 1][i - 1] = std::max(maxSurface[j - 1][i - 1], surface);
+        }
+      }
+    }
+  };
+
+  Ensemble::Ensemble(int nx, int ny, RealType dx, RealType dy, std::vector<RealType> thresholds):
+    nx_(nx),
+    ny_(ny),
+    dx_(dx),
+    dy_(dy),
+    base_(std::make_unique<EnsembleMember>(nx, ny, dx, dy)),
+    displacement_(ny, nx),
+    thresholds_(std::move(thresholds)),
+    histograms_(size_t(nx) * ny * (thresholds_.size() + 1)) {
+
+    assert(std::is_sorted(thresholds_.begin(), thresholds_.end()));
+  }
+
+  Ensemble::~Ensemble() = default;
+
+  void Ensemble::initialiseScenario(RealType offsetX, RealType offsetY, const Scenarios::Scenario& scenario) {
+    SWE_TRACE_ZONE("Initialise Ensemble");
+
+    base_->initialiseScenario(offsetX, offsetY, scenario);
+    base_->extractDisplacement(displacement_);
+
+    std::fill(histograms_.begin(), histograms_.end(), uint32_t(0));
+    members_ = 0;
+    failed_  = 0;
+  }
+
+  int64_t Ensemble::run(const std::vector<EnsembleVariant>& variants, RealType endTime) {
+    SWE_TRACE_ZONE("Ensemble");
+
+    int64_t    steps = 0;
+    std::mutex mutex;
+
+    // One chunk of members per thread, the sweeps of a member are split further if threads are idle
+    Core::parallelFor(0, int(variants.size()), [&](int begin, int end) {
+      EnsembleMember member(nx_, ny_, dx_, dy_);
+      Float2D<float> maxSurface(ny_, nx_);
+      int64_t        memberSteps = 0;
+
+      for (int k = begin; k < end; k++) {
+        SWE_TRACE_ZONE("Ensemble Member");
+
+        member.initialiseFromBase(*base_);
+        member.addDisplacement(displacement_, variants[k]);
+        std::fill_n(maxSurface.getData(), size_t(nx_) * ny_, -std::numeric_limits<float>::infinity());
+        member.updateMaxSurface(maxSurface);
+
+        RealType time  = RealType(0.0);
+        bool     error = false;
+        while (time < endTime && !error) {
+          member.setGhostLayer();
+          member.computeMaxTimeStep();
+          RealType dt = std::min(member.getMaxTimeStep(), endTime - time);
+
+          member.simulateTimeStep(dt);
+          member.updateMaxSurface(maxSurface);
+          error = member.hasError();
+          time += dt;
+          memberSteps++;
+        }
+
+        std::lock_guard lock(mutex);
+        if (error) {
+          failed_++;
+        } else {
+          addToStatistics(maxSurface);
+        }
+      }
+
+      std::lock_guard lock(mutex);
+      steps += memberSteps;
+    });
+
+    return steps;
+  }
+
+  void Ensemble::addToStatistics(const Float2D<float>& maxSurface) {
+    size_t bins = thresholds_.size() + 1;
+    for (int j = 0; j < ny_; j++) {
+      for (int i = 0; i < nx_; i++) {
+        size_t bin = std::upper_bound(thresholds_.begin(), thresholds_.end(), RealType(maxSurface[j][i])) - thresholds_.begin();
+        histograms_[(size_t(j) * nx_ + i) * bins + bin]++;
+      }
+    }
+    members_++;
+  }
+
+  int Ensemble::getMemberCount() const { return members_; }
+
+  int Ensemble::getFailedCount() const { return failed_; }
+
+  const std::vector<RealType>& Ensemble::getThresholds() const { return thresholds_; }
+
+  float Ensemble::getExceedanceProbability(int i, int j, int threshold) const {
+    if (members_ == 0) {
+      return 0.0f;
+    }
+
+    size_t          bins      = thresholds_.size() + 1;
+    const uint32_t* histogram = &histograms_[(size_t(j) * nx_ + i) * bins];
+
+    int count = 0;
+    for (size_t bin = threshold + 1; bin < bins; bin++) {
+      count += histogram[bin];
+    }
+    return float(count) / float(members_);
+  }
+
+  RealType Ensemble::getPercentile(int i, int j, float p) const {
+    if (members_ == 0) {
+      return RealType(0.0);
+    }
+
+    size_t          bins      = thresholds_.size() + 1;
+    const uint32_t* histogram = &histograms_[(size_t(j) * nx_ + i) * bins];
+
+    float target = std::clamp(p, 0.0f, 1.0f) * float(members_);
+    int   below  = 0;
+    for (size_t bin = 0; bin < bins; bin++) {
+      int count = histogram[bin];
+      if (count > 0 && float(below + count) >= target) {
+        if (bin == 0) {
+          return RealType(0.0);
+        }
+        if (bin == bins - 1) {
+          return thresholds_.back();
+        }
+        RealType lower = thresholds_[bin - 1];
+        RealType upper = thresholds_[bin];
+        return lower + (upper - lower) * RealType((target - float(below)) / float(count));
+      }
+      below += count;
+    }
+    return thresholds_.empty() ? RealType(0.0) : thresholds_.back();
+  }
+
+  size_t Ensemble::getMemoryUsage() const {
+    return base_->getMemoryUsage() + sizeof(RealType) * size_t(nx_) * ny_ + sizeof(uint32_t) * histograms_.size();
+  }
+
+  std::vector<RealType> Ensemble::getDefaultThresholds() {
+    std::vector<RealType> thresholds;
+    for (int k = 0; k < 16; k++) {
+      thresholds.push_back(RealType(0.1 * std::pow(2.0, 0.5 * k)));
+    }
+    return thresholds;
+  }
+
+} // namespace Blocks
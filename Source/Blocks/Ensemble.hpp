@@ -0,0 +1,99 @@
+/**
+ * @file Ensemble.hpp
+ * @brief Runs many source variants of one scenario against a shared bathymetry
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Scenarios/Scenario.hpp"
+#include "Types/BoundaryType.hpp"
+#include "Types/Float2D.hpp"
+#include "Types/RealType.hpp"
+
+namespace Blocks {
+
+  class EnsembleMember;
+
+  /// Source of an ensemble member, derived from the displacement of the scenario
+  struct EnsembleVariant {
+    RealType scale  = RealType(1.0); ///< Factor on the displacement
+    RealType shiftX = RealType(0.0); ///< Shift of the displacement in x-direction, rounded to whole cells
+    RealType shiftY = RealType(0.0); ///< Shift of the displacement in y-direction, rounded to whole cells
+  };
+
+  /**
+   * @brief Ensemble of simulations that differ only in their tsunami source
+   *
+   * The scenario is sampled once. All members share its bathymetry (read only) and boundary types, and start from
+   * its initial sea surface with the displacement replaced by a scaled and shifted copy of it. The members run in
+   * parallel, each to the same end time with its own time steps, so one member only needs the memory of its
+   * unknowns and net updates while it runs.
+   *
+   * Instead of storing the members, the maximum sea surface elevation of every cell is folded into a histogram
+   * over fixed thresholds as soon as a member is done. Exceedance probabilities and percentiles of the maximum
+   * are read from the histograms, their memory does not depend on the number of members.
+   */
+  class Ensemble {
+  public:
+    /**
+     * @param thresholds Ascending surface elevations (m) of the histogram, the resolution of the percentiles
+     */
+    Ensemble(int nx, int ny, RealType dx, RealType dy, std::vector<RealType> thresholds = getDefaultThresholds());
+    ~Ensemble();
+
+    Ensemble(const Ensemble&) = delete;
+
+    /// Samples the scenario, see Blocks::Block::initialiseScenario. Resets the statistics.
+    void initialiseScenario(RealType offsetX, RealType offsetY, const Scenarios::Scenario& scenario);
+
+    /**
+     * Simulates the variants until endTime and adds them to the statistics. Can be called repeatedly.
+     *
+     * @return Number of time steps of all members
+     */
+    int64_t run(const std::vector<EnsembleVariant>& variants, RealType endTime);
+
+    /// Members in the statistics
+    int getMemberCount() const;
+    /// Members that were dropped because the solver failed
+    int getFailedCount() const;
+
+    const std::vector<RealType>& getThresholds() const;
+
+    /// Fraction of the members whose maximum surface elevation in inner cell (i, j) reached thresholds[threshold]
+    float getExceedanceProbability(int i, int j, int threshold) const;
+
+    /**
+     * Maximum surface elevation in inner cell (i, j) that a fraction p of the members did not exceed, interpolated
+     * within the histogram bin. Returns 0 below the first threshold and the last threshold above it.
+     */
+    RealType getPercentile(int i, int j, float p) const;
+
+    /// Returns the memory held by the shared data and the statistics in bytes (without running members)
+    size_t getMemoryUsage() const;
+
+    /// Thresholds from 0.1 m to about 18 m, a factor sqrt(2) apart
+    static std::vector<RealType> getDefaultThresholds();
+
+  private:
+    void addToStatistics(const Float2D<float>& maxSurface);
+
+    int      nx_;
+    int      ny_;
+    RealType dx_;
+    RealType dy_;
+
+    std::unique_ptr<EnsembleMember> base_;         ///< Initial state without displacement, owns the shared bathymetry
+    Float2D<RealType>               displacement_; ///< Displacement of the scenario in the wet inner cells
+
+    std::vector<RealType> thresholds_;
+    std::vector<uint32_t> histograms_; ///< thresholds_.size() + 1 bins per inner cell, bin k counts maxima in [thresholds_[k - 1], thresholds_[k]) (32 bit counts, they cannot overflow before members_)
+    int                   members_ = 0;
+    int                   failed_  = 0;
+  };
+
+} // namespace Blocks
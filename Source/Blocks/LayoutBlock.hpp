@@ -0,0 +1,226 @@
+/**
+ * @file LayoutBlock.hpp
+ * @brief Dimensional splitting on cells stored in a selectable layout
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <vector>
+
+#include "Blocks/Block.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/PerfCounters.hpp"
+#include "Core/Trace.hpp"
+#include "Solvers/Fwave.hpp"
+#include "Types/CellLayout.hpp"
+#include "Types/Float2D.hpp"
+
+namespace Blocks {
+
+  /**
+   * @brief The scheme of Blocks::DimensionalSplittingBlock with the cells stored in the layout policy Layout
+   *
+   * Steps give the same results as the original block for every layout (with the same boundary types), so the
+   * layouts can be compared for the sweeps. Blocks::Block keeps its separate arrays (SoALayout), the scenarios
+   * and the app read them directly.
+   */
+  template <class Layout>
+  class LayoutBlock {
+  public:
+    /// Copies the unknowns, bathymetry (incl. ghost layer) and boundary types of source
+    explicit LayoutBlock(const Block& source):
+      nx_(source.getNx()),
+      ny_(source.getNy()),
+      cols_(nx_ + 2),
+      rows_(ny_ + 2),
+      dx_(source.getDx()),
+      dy_(source.getDy()),
+      data_(Layout::getSize(cols_, rows_)),
+      hNetUpdatesLeft_(ny_ + 2, nx_ + 1),
+      hNetUpdatesRight_(ny_ + 2, nx_ + 1),
+      huNetUpdatesLeft_(ny_ + 2, nx_ + 1),
+      huNetUpdatesRight_(ny_ + 2, nx_ + 1) {
+
+      for (int edge = 0; edge < 4; edge++) {
+        boundary_[edge] = source.getBoundaryType(BoundaryEdge(edge));
+      }
+
+      const Float2D<RealType>* arrays[QuantityCount] = {&source.getWaterHeight(), &source.getDischargeHu(), &source.getDischargeHv(), &source.getBathymetry()};
+      for (int q = 0; q < QuantityCount; q++) {
+        for (int y = 0; y < rows_; y++) {
+          for (int x = 0; x < cols_; x++) {
+            at(q, x, y) = (*arrays[q])[y][x];
+          }
+        }
+      }
+    }
+
+    LayoutBlock(const LayoutBlock&) = delete;
+
+    RealType getValue(int quantity, int x, int y) const { return data_[Layout::getIndex(quantity, x, y, cols_, rows_)]; }
+
+    RealType getMaxTimeStep() const { return maxTimeStep_; }
+
+    bool hasError() {
+      bool e        = solver_.Error;
+      solver_.Error = false;
+      return e;
+    }
+
+    size_t getMemoryUsage() const { return sizeof(RealType) * (data_.size() + 4 * size_t(hNetUpdatesLeft_.getRows()) * hNetUpdatesLeft_.getCols()); }
+
+    /// Sets the ghost layer like Blocks::Block::setGhostLayer
+    void setGhostLayer() {
+      SWE_TRACE_ZONE("Ghost Layer");
+
+      // Copies cell (fromX, fromY) to the ghost cell (x, y), negating the momentum normal to the boundary at walls
+      auto copyCell = [this](int x, int y, int fromX, int fromY, int normal, bool wall) {
+        for (int q = 0; q < QuantityB; q++) {
+          RealType value = at(q, fromX, fromY);
+          at(q, x, y)    = wall && q == normal ? -value : value;
+        }
+      };
+
+      for (int y = 1; y <= ny_; y++) {
+        copyCell(0, y, 1, y, QuantityHu, boundary_[BoundaryEdge::Left] == BoundaryType::Wall);
+        copyCell(nx_ + 1, y, nx_, y, QuantityHu, boundary_[BoundaryEdge::Right] == BoundaryType::Wall);
+      }
+      for (int x = 1; x <= nx_; x++) {
+        copyCell(x, 0, x, 1, QuantityHv, boundary_[BoundaryEdge::Bottom] == BoundaryType::Wall);
+        copyCell(x, ny_ + 1, x, ny_, QuantityHv, boundary_[BoundaryEdge::Top] == BoundaryType::Wall);
+      }
+
+      // Corners get the values of the diagonal neighbours, see Blocks::Block::setBoundaryConditions
+      copyCell(0, 0, 1, 1, QuantityHu, false);
+      copyCell(0, ny_ + 1, 1, ny_, QuantityHu, false);
+      copyCell(nx_ + 1, 0, nx_, 1, QuantityHu, false);
+      copyCell(nx_ + 1, ny_ + 1, nx_, ny_, QuantityHu, false);
+    }
+
+    /// X-sweep, see Blocks::DimensionalSplittingBlock::computeNumericalFluxes
+    void computeNumericalFluxes() {
+      SWE_PERF_SCOPE(XSweep);
+      SWE_TRACE_ZONE("X-Sweep");
+
+      RealType   maxWaveSpeedX = RealType(0.0);
+      std::mutex maxMutex;
+
+      Core::parallelFor(
+        0,
+        ny_ + 2,
+        [&](int yBegin, int yEnd) {
+          std::vector<RealType> waveSpeeds(nx_ + 1);
+          RealType              maxChunkSpeedX = RealType(0.0);
+
+          for (int y = yBegin; y < yEnd; y++) {
+            RealType maxRowSpeedX = solver_.computeNetUpdatesRow(
+              nx_ + 1,
+              Layout::getRow(data_.data(), QuantityHu, 0, y, cols_, rows_),
+              Layout::getRow(data_.data(), QuantityHu, 1, y, cols_, rows_),
+              hNetUpdatesLeft_[y],
+              hNetUpdatesRight_[y],
+              huNetUpdatesLeft_[y],
+              huNetUpdatesRight_[y],
+              waveSpeeds.data()
+            );
+            maxChunkSpeedX = std::max(maxChunkSpeedX, maxRowSpeedX);
+          }
+
+          std::lock_guard lock(maxMutex);
+          maxWaveSpeedX = std::max(maxWaveSpeedX, maxChunkSpeedX);
+        },
+        getMinRowsPerChunk()
+      );
+
+      assert(maxWaveSpeedX > RealType(0.0));
+      maxTimeStep_ = dx_ / maxWaveSpeedX * RealType(0.4);
+    }
+
+    /// X-update and y-sweep, see Blocks::DimensionalSplittingBlock::updateUnknowns
+    void updateUnknowns(RealType dt) {
+      {
+        SWE_PERF_SCOPE(XSweep);
+        SWE_TRACE_ZONE("X-Update");
+
+        Core::parallelFor(
+          0,
+          ny_ + 2,
+          [&](int yBegin, int yEnd) {
+            for (int y = yBegin; y < yEnd; y++) {
+              for (int x = 1; x < nx_ + 1; x++) {
+                at(QuantityH, x, y) -= dt / dx_ * (hNetUpdatesRight_[y][x - 1] + hNetUpdatesLeft_[y][x]);
+                at(QuantityHu, x, y) -= dt / dx_ * (huNetUpdatesRight_[y][x - 1] + huNetUpdatesLeft_[y][x]);
+              }
+            }
+          },
+          getMinRowsPerChunk()
+        );
+      }
+
+      SWE_PERF_SCOPE(YSweep);
+      SWE_TRACE_ZONE("Y-Sweep");
+
+      Core::parallelFor(
+        1,
+        ny_ + 2,
+        [&](int yBegin, int yEnd) {
+          std::vector<RealType> waveSpeeds(nx_);
+          for (int y = yBegin; y < yEnd; y++) {
+            solver_.computeNetUpdatesRow(
+              nx_,
+              Layout::getRow(data_.data(), QuantityHv, 1, y - 1, cols_, rows_),
+              Layout::getRow(data_.data(), QuantityHv, 1, y, cols_, rows_),
+              hNetUpdatesLeft_[y - 1] + 1,
+              hNetUpdatesRight_[y - 1] + 1,
+              huNetUpdatesLeft_[y - 1] + 1,
+              huNetUpdatesRight_[y - 1] + 1,
+              waveSpeeds.data()
+            );
+          }
+        },
+        getMinRowsPerChunk()
+      );
+
+      Core::parallelFor(
+        1,
+        ny_ + 1,
+        [&](int yBegin, int yEnd) {
+          for (int y = yBegin; y < yEnd; y++) {
+            for (int x = 1; x < nx_ + 1; x++) {
+              at(QuantityH, x, y) -= dt / dy_ * (hNetUpdatesRight_[y - 1][x] + hNetUpdatesLeft_[y][x]);
+              at(QuantityHv, x, y) -= dt / dy_ * (huNetUpdatesRight_[y - 1][x] + huNetUpdatesLeft_[y][x]);
+            }
+          }
+        },
+        getMinRowsPerChunk()
+      );
+    }
+
+  private:
+    RealType& at(int quantity, int x, int y) { return data_[Layout::getIndex(quantity, x, y, cols_, rows_)]; }
+
+    int getMinRowsPerChunk() const { return std::max(1, 16384 / (nx_ + 1)); }
+
+    int      nx_;
+    int      ny_;
+    int      cols_;
+    int      rows_;
+    RealType dx_;
+    RealType dy_;
+    RealType maxTimeStep_ = RealType(0.0);
+
+    BoundaryType          boundary_[4];
+    std::vector<RealType> data_;
+
+    Float2D<RealType> hNetUpdatesLeft_;
+    Float2D<RealType> hNetUpdatesRight_;
+    Float2D<RealType> huNetUpdatesLeft_;
+    Float2D<RealType> huNetUpdatesRight_;
+
+    Solvers::Fwave solver_;
+  };
+
+} // namespace Blocks
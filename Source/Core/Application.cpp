@@ -4,6 +4,9 @@
 #include <GLFW/glfw3.h>
 
 #include "ImGui/ImGuiBgfx.hpp"
+#include "Parallel.hpp"
+#include "Profiler.hpp"
+#include "Trace.hpp"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
@@ -34,6 +37,11 @@ namespace Core {
     }
     s_app = this;
 
+    SWE_TRACE_THREAD("Main");
+
+    // Up front, so that the threads are running before the main thread blocks on them the first time
+    initThreadPool();
+
     glfwSetErrorCallback([](int error, const char* description) { std::cerr << "GLFW error " << error << ": " << description << std::endl; });
 
     if (!glfwInit()) {
@@ -119,6 +127,12 @@ namespace Core {
   }
 
   Application::~Application() {
+#ifdef ENABLE_TRACING
+    if (Trace::isRecording() && !Trace::stop()) {
+      std::cerr << "Failed to write trace " << Trace::getPath() << std::endl;
+    }
+#endif
+
     ImGuiBgfx::destroyImGuiContext();
 
     bgfx::shutdown();
@@ -132,21 +146,31 @@ namespace Core {
     emscripten_set_main_loop(emscriptenMainLoop, 0, true);
 #else
     while (!glfwWindowShouldClose(m_window)) {
+      SWE_TRACE_ZONE("Frame");
+
       glfwPollEvents();
 
       float dt = ImGui::GetIO().DeltaTime;
 
-      ImGuiBgfx::beginImGuiFrame();
-      updateImGui(dt);
-      ImGuiBgfx::endImGuiFrame();
+      {
+        SWE_PROFILE_SCOPE(ImGui);
+        SWE_TRACE_ZONE("ImGui");
+        ImGuiBgfx::beginImGuiFrame();
+        updateImGui(dt);
+        ImGuiBgfx::endImGuiFrame();
+      }
 
       update(dt);
+
+      Profiler::endFrame();
     }
 #endif
   }
 
 #ifdef __EMSCRIPTEN__
   void Application::emscriptenMainLoop() {
+    SWE_TRACE_ZONE("Frame");
+
     glfwPollEvents();
 
     if (glfwWindowShouldClose(s_app->m_window)) {
@@ -156,13 +180,19 @@ namespace Core {
 
     float dt = ImGui::GetIO().DeltaTime;
 
-    ImGuiBgfx::beginImGuiFrame();
-    s_app->updateImGui(dt);
-    ImGuiBgfx::endImGuiFrame();
+    {
+      SWE_PROFILE_SCOPE(ImGui);
+      SWE_TRACE_ZONE("ImGui");
+      ImGuiBgfx::beginImGuiFrame();
+      s_app->updateImGui(dt);
+      ImGuiBgfx::endImGuiFrame();
+    }
 
     emscriptenUpdateCursor();
 
     s_app->update(dt);
+
+    Profiler::endFrame();
   }
 
   void Application::emscriptenUpdateCursor() {
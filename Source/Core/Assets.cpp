@@ -0,0 +1,125 @@
+#include "Assets.hpp"
+
+#ifdef __EMSCRIPTEN__
+#include <cstdint>
+#include <cstdlib>
+#include <emscripten/emscripten.h>
+#include <memory>
+#include <unordered_map>
+
+#include "MappedFile.hpp"
+#include "Trace.hpp"
+#endif
+
+namespace Core {
+
+#ifdef __EMSCRIPTEN__
+  // Files of one fetchAssets call that are still downloading
+  struct AssetRequest {
+    std::function<void(bool)> onDone;
+    int                       pending = 0;
+    bool                      success = true;
+  };
+
+  struct AssetDownload {
+    std::string                   path;
+    std::shared_ptr<AssetRequest> request;
+  };
+
+  static std::unordered_map<int, AssetDownload> s_downloads;
+  static int                                    s_nextDownloadId = 0;
+
+  // Streams the decompressed response into a growing buffer of the module, calls sweOnAssetFetched with it
+  EM_JS_DEPS(sweAssets, "$UTF8ToString,malloc,realloc,free");
+  EM_JS(void, sweFetchAsset, (const char* url, int id), {
+    fetch(UTF8ToString(url))
+      .then(response => {
+        if (!response.ok) {
+          throw new Error(response.status + ' ' + response.statusText);
+        }
+
+        // Some servers (e.g. emrun) send .gz files with Content-Encoding, then the browser has decompressed them already
+        const encoded = (response.headers.get('Content-Encoding') || '').includes('gzip');
+        const body    = encoded ? response.body : response.body.pipeThrough(new DecompressionStream('gzip'));
+        const reader  = body.getReader();
+
+        let capacity = Math.max(Number(response.headers.get('Content-Length')) * 2, 1 << 20);
+        let size     = 0;
+        let data     = _malloc(capacity);
+
+        const pump = () => reader.read().then(({done, value}) => {
+          if (done) {
+            _sweOnAssetFetched(id, data, size);
+            return;
+          }
+          if (size + value.length > capacity) {
+            while (size + value.length > capacity) {
+              capacity *= 2;
+            }
+            data = _realloc(data, capacity);
+          }
+          HEAPU8.set(value, data + size);
+          size += value.length;
+          return pump();
+        });
+        return pump().catch(error => {
+          _free(data);
+          throw error;
+        });
+      })
+      .catch(error => {
+        console.error('Failed to download ' + UTF8ToString(url) + ': ' + error);
+        _sweOnAssetFetched(id, 0, 0);
+      });
+  });
+
+  extern "C" EMSCRIPTEN_KEEPALIVE void sweOnAssetFetched(int id, uint8_t* data, size_t size) {
+    auto it = s_downloads.find(id);
+    if (it == s_downloads.end()) {
+      std::free(data);
+      return;
+    }
+
+    AssetDownload download = std::move(it->second);
+    s_downloads.erase(it);
+
+    if (data) {
+      MappedFile::addShared(download.path, data, size);
+    } else {
+      download.request->success = false;
+    }
+
+    if (--download.request->pending == 0) {
+      download.request->onDone(download.request->success);
+    }
+  }
+
+  void fetchAssets(const std::vector<std::string>& paths, std::function<void(bool success)> onDone) {
+    SWE_TRACE_ZONE("Fetch Assets");
+
+    auto request    = std::make_shared<AssetRequest>();
+    request->onDone = std::move(onDone);
+
+    for (const std::string& path : paths) {
+      if (MappedFile::isShared(path)) {
+        continue;
+      }
+
+      // Downloads of files that are already on the way are not shared, the second one just replaces the first
+      int id          = s_nextDownloadId++;
+      s_downloads[id] = {path, request};
+      request->pending++;
+
+      std::string url = path + ".gz";
+      sweFetchAsset(url.c_str(), id);
+    }
+
+    if (request->pending == 0) {
+      request->onDone(true);
+    }
+  }
+#else
+  void fetchAssets(const std::vector<std::string>&, std::function<void(bool success)> onDone) { onDone(true); }
+#endif
+
+} // namespace Core
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+  /**
+   * Makes asset files available to MappedFile::openShared, downloading them on demand in the web build.
+   *
+   * The web build serves every asset gzip compressed next to the page (path + ".gz"). The browser decompresses
+   * the download while it streams into a buffer of the module, which is then added to the shared mappings, so the
+   * files are read like local files afterwards. Files that were fetched before are not downloaded again.
+   * On other platforms the files are read from disk when they are opened and onDone is called right away.
+   *
+   * @param onDone Called on the main thread once all files are available, success is false if a download failed.
+   */
+  void fetchAssets(const std::vector<std::string>& paths, std::function<void(bool success)> onDone);
+
+} // namespace Core
@@ -0,0 +1,74 @@
+#include "Isa.hpp"
+
+#include <atomic>
+
+namespace Core {
+
+  static Isa detectIsa() {
+#ifdef SWE_ISA_DISPATCH
+    // Also checks that the operating system saves the AVX registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")) {
+      return Isa::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+      return Isa::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+      return Isa::SSE42;
+    }
+#endif
+    return Isa::Generic;
+  }
+
+  // Selected level, Count until the first call of getIsa or setIsa
+  static std::atomic<Isa> s_isa = Isa::Count;
+
+  Isa getBestIsa() {
+    static const Isa best = detectIsa();
+    return best;
+  }
+
+  Isa getIsa() {
+    Isa isa = s_isa.load(std::memory_order_relaxed);
+    if (isa == Isa::Count) {
+      isa = getBestIsa();
+      s_isa.store(isa, std::memory_order_relaxed);
+    }
+    return isa;
+  }
+
+  bool setIsa(Isa isa) {
+    if (isa >= Isa::Count || isa > getBestIsa()) {
+      return false;
+    }
+    s_isa.store(isa, std::memory_order_relaxed);
+    return true;
+  }
+
+  const char* getIsaName(Isa isa) {
+    switch (isa) {
+    case Isa::Generic:
+      return "generic";
+    case Isa::SSE42:
+      return "sse4.2";
+    case Isa::AVX2:
+      return "avx2";
+    case Isa::AVX512:
+      return "avx512";
+    default:
+      return "unknown";
+    }
+  }
+
+  bool parseIsa(std::string_view name, Isa& o_isa) {
+    for (int i = 0; i < int(Isa::Count); i++) {
+      if (name == getIsaName(Isa(i))) {
+        o_isa = Isa(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+} // namespace Core
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string_view>
+#include <utility>
+
+/**
+ * Runtime selection of the instruction set used by the hot kernels (solver rows, view extraction).
+ *
+ * The kernels are compiled once per level into the same binary with target attributes. SWE_ISA_CALL picks the
+ * variant of the level returned by Core::getIsa(): the best one the CPU supports, unless it was forced with
+ * Core::setIsa. Other platforms and compilers (Emscripten, MSVC, ARM) only have the generic variant, which uses
+ * the flags of the build.
+ *
+ * The build disables contraction into FMA (-ffp-contract=off, AVX-512 implies FMA), so all variants give the
+ * same results.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SWE_ISA_DISPATCH
+#endif
+
+#ifdef SWE_ISA_DISPATCH
+#define SWE_FORCE_INLINE    __attribute__((always_inline)) inline
+#define SWE_TARGET_SSE42    __attribute__((target("sse4.2,popcnt")))
+#define SWE_TARGET_AVX2     __attribute__((target("avx2,popcnt")))
+#define SWE_TARGET_AVX512   __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,popcnt")))
+
+/// Defines name##Sse42, name##Avx2 and name##Avx512, which forward to name (SWE_FORCE_INLINE) compiled for their level
+#define SWE_ISA_VARIANTS(ReturnType, name) \
+  template <class... Args> \
+  SWE_TARGET_SSE42 static ReturnType name##Sse42(Args&&... args) { \
+    return name(std::forward<Args>(args)...); \
+  } \
+  template <class... Args> \
+  SWE_TARGET_AVX2 static ReturnType name##Avx2(Args&&... args) { \
+    return name(std::forward<Args>(args)...); \
+  } \
+  template <class... Args> \
+  SWE_TARGET_AVX512 static ReturnType name##Avx512(Args&&... args) { \
+    return name(std::forward<Args>(args)...); \
+  }
+
+/// Calls the variant of name (see SWE_ISA_VARIANTS) for the selected instruction set
+#define SWE_ISA_CALL(name, ...) \
+  (Core::getIsa() == Core::Isa::AVX512  ? name##Avx512(__VA_ARGS__) \
+   : Core::getIsa() == Core::Isa::AVX2  ? name##Avx2(__VA_ARGS__) \
+   : Core::getIsa() == Core::Isa::SSE42 ? name##Sse42(__VA_ARGS__) \
+                                        : name(__VA_ARGS__))
+#else
+#define SWE_FORCE_INLINE inline
+#define SWE_ISA_VARIANTS(ReturnType, name)
+#define SWE_ISA_CALL(name, ...) name(__VA_ARGS__)
+#endif
+
+namespace Core {
+
+  /// Instruction set levels of the kernel variants, in ascending order
+  enum class Isa {
+    Generic, // Flags of the build
+    SSE42,   // Nehalem and later
+    AVX2,    // Haswell, Zen and later
+    AVX512,  // Skylake-SP, Ice Lake, Sapphire Rapids, Zen 4 (F, DQ, BW and VL)
+    Count
+  };
+
+  /// Best level of the CPU that the binary has variants for
+  Isa getBestIsa();
+
+  /// Level used by SWE_ISA_CALL, getBestIsa() unless forced with setIsa
+  Isa getIsa();
+
+  /// Forces a level, returns false (keeping the current one) if the CPU does not support it
+  bool setIsa(Isa isa);
+
+  const char* getIsaName(Isa isa);
+
+  /// Parses generic, sse4.2, avx2 or avx512, returns false for other names
+  bool parseIsa(std::string_view name, Isa& o_isa);
+
+} // namespace Core
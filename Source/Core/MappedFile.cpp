@@ -0,0 +1,165 @@
+#include "MappedFile.hpp"
+
+#include <bx/platform.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#if BX_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Core {
+
+  static std::mutex                                                        s_cacheMutex;
+  static std::unordered_map<std::string, std::shared_ptr<const MappedFile>> s_cache;
+
+  // Size and last write time of a file, which change if it is rewritten
+  static bool getFileStamp(const std::string& path, size_t& size, int64_t& writeTime) {
+    std::error_code error;
+    size = (size_t)std::filesystem::file_size(path, error);
+    if (error) {
+      return false;
+    }
+    writeTime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    return !error;
+  }
+
+  MappedFile::~MappedFile() {
+    std::free(m_allocation);
+
+    if (!m_mapping) {
+      return;
+    }
+#if BX_PLATFORM_WINDOWS
+    UnmapViewOfFile(m_data);
+    CloseHandle((HANDLE)m_mapping);
+#elif !defined(__EMSCRIPTEN__)
+    munmap(m_mapping, m_size);
+#endif
+  }
+
+  std::unique_ptr<MappedFile> MappedFile::open(const std::string& path) {
+    std::unique_ptr<MappedFile> file(new MappedFile());
+
+    // Taken before mapping, so a file rewritten in between is detected as changed by openShared (the size compared
+    // there is the one of the mapping)
+    size_t stampSize;
+    if (!getFileStamp(path, stampSize, file->m_writeTime)) {
+      return nullptr;
+    }
+
+#if BX_PLATFORM_WINDOWS
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+      return nullptr;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+      CloseHandle(handle);
+      return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle); // The mapping keeps its own reference to the file
+    if (!mapping) {
+      return nullptr;
+    }
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+      CloseHandle(mapping);
+      return nullptr;
+    }
+
+    file->m_data    = static_cast<const uint8_t*>(data);
+    file->m_size    = (size_t)size.QuadPart;
+    file->m_mapping = mapping;
+#elif !defined(__EMSCRIPTEN__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return nullptr;
+    }
+
+    void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file
+    if (data == MAP_FAILED) {
+      return nullptr;
+    }
+
+    file->m_data    = static_cast<const uint8_t*>(data);
+    file->m_size    = (size_t)st.st_size;
+    file->m_mapping = data;
+#else
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+      return nullptr;
+    }
+
+    file->m_buffer.resize((size_t)stream.tellg());
+    stream.seekg(0);
+    if (file->m_buffer.empty() || !stream.read(reinterpret_cast<char*>(file->m_buffer.data()), file->m_buffer.size())) {
+      return nullptr;
+    }
+
+    file->m_data = file->m_buffer.data();
+    file->m_size = file->m_buffer.size();
+#endif
+
+    return file;
+  }
+
+  std::shared_ptr<const MappedFile> MappedFile::openShared(const std::string& path) {
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+
+    auto it = s_cache.find(path);
+    if (it != s_cache.end()) {
+      const MappedFile& cached = *it->second;
+
+      size_t  size;
+      int64_t writeTime;
+      if (cached.m_allocation || (getFileStamp(path, size, writeTime) && size == cached.m_size && writeTime == cached.m_writeTime)) {
+        return it->second;
+      }
+      s_cache.erase(it); // Rewritten since it was mapped
+    }
+
+    std::shared_ptr<const MappedFile> file = open(path);
+    if (file) {
+      s_cache.emplace(path, file);
+    }
+    return file;
+  }
+
+  void MappedFile::addShared(const std::string& path, uint8_t* data, size_t size) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->m_data       = data;
+    file->m_size       = size;
+    file->m_allocation = data;
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    s_cache[path] = std::move(file);
+  }
+
+  bool MappedFile::isShared(const std::string& path) {
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    return s_cache.count(path) > 0;
+  }
+
+} // namespace Core
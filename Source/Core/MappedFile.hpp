@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+  /**
+   * Read-only view of a whole file mapped into memory.
+   *
+   * On platforms without mmap support (Emscripten) the file is read into a heap buffer instead,
+   * so the interface stays the same.
+   */
+  class MappedFile {
+  public:
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Maps the file read-only. Returns nullptr if the file cannot be opened or mapped.
+     */
+    static std::unique_ptr<MappedFile> open(const std::string& path);
+
+    /**
+     * Returns a mapping of the file that is shared with all other callers requesting the same path.
+     *
+     * Mappings stay cached for the lifetime of the process, repeated requests only check the size and last write
+     * time of the file. A file that was rewritten is mapped again, earlier callers keep the old mapping (which may
+     * show parts of the new contents, or fault if the file was truncated).
+     */
+    static std::shared_ptr<const MappedFile> openShared(const std::string& path);
+
+    /**
+     * Adds a file that is held in memory (e.g. downloaded) to the shared mappings, so that openShared returns it for path.
+     * Takes ownership of data, which has to be allocated with malloc.
+     */
+    static void addShared(const std::string& path, uint8_t* data, size_t size);
+
+    /// Returns true if openShared has a mapping of path cached
+    static bool isShared(const std::string& path);
+
+    const uint8_t* getData() const { return m_data; }
+    size_t         getSize() const { return m_size; }
+
+    /// Last write time of the file when it was mapped (ticks of the file clock), 0 for files added with addShared
+    int64_t getWriteTime() const { return m_writeTime; }
+
+  private:
+    MappedFile() = default;
+
+    const uint8_t* m_data      = nullptr;
+    size_t         m_size      = 0;
+    int64_t        m_writeTime = 0;
+
+    void* m_mapping = nullptr; // Platform specific mapping handle
+
+    std::vector<uint8_t> m_buffer; // Fallback storage if the file is read instead of mapped
+
+    uint8_t* m_allocation = nullptr; // Memory of a file added with addShared
+  };
+
+} // namespace Core
@@ -0,0 +1,135 @@
+#include "MappedStorage.hpp"
+
+#include <algorithm>
+#include <bx/platform.h>
+
+#if BX_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Core {
+
+#if !BX_PLATFORM_WINDOWS && !defined(__EMSCRIPTEN__)
+  // The hints work on whole pages, ranges are extended to the pages they touch
+  static void getPageRange(size_t offset, size_t size, size_t totalSize, size_t& begin, size_t& end) {
+    size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+    begin           = offset / pageSize * pageSize;
+    end             = std::min(totalSize, (offset + size + pageSize - 1) / pageSize * pageSize);
+  }
+#endif
+
+  MappedStorage::~MappedStorage() {
+    if (!m_mapping) {
+      return;
+    }
+#if BX_PLATFORM_WINDOWS
+    UnmapViewOfFile(m_data);
+    CloseHandle((HANDLE)m_mapping);
+#elif !defined(__EMSCRIPTEN__)
+    munmap(m_mapping, m_size);
+    close(m_file);
+#endif
+  }
+
+  std::unique_ptr<MappedStorage> MappedStorage::create(const std::string& path, size_t size) {
+    if (size == 0) {
+      return nullptr;
+    }
+    std::unique_ptr<MappedStorage> storage(new MappedStorage());
+
+#if BX_PLATFORM_WINDOWS
+    // The file is deleted when the last handle (the one of the mapping) is closed
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+      return nullptr;
+    }
+
+    LARGE_INTEGER fileSize;
+    fileSize.QuadPart = LONGLONG(size);
+    HANDLE mapping    = CreateFileMappingA(handle, nullptr, PAGE_READWRITE, DWORD(fileSize.HighPart), fileSize.LowPart, nullptr);
+    CloseHandle(handle);
+    if (!mapping) {
+      return nullptr;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+    if (!data) {
+      CloseHandle(mapping);
+      return nullptr;
+    }
+
+    storage->m_data    = static_cast<uint8_t*>(data);
+    storage->m_size    = size;
+    storage->m_mapping = mapping;
+#elif !defined(__EMSCRIPTEN__)
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+      return nullptr;
+    }
+    unlink(path.c_str()); // The file stays until it is closed
+
+    if (ftruncate(fd, off_t(size)) != 0) {
+      close(fd);
+      return nullptr;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return nullptr;
+    }
+
+    storage->m_data    = static_cast<uint8_t*>(data);
+    storage->m_size    = size;
+    storage->m_mapping = data;
+    storage->m_file    = fd; // Kept open to start the write-back of ranges
+#else
+    (void)path;
+    storage->m_buffer.resize(size);
+    storage->m_data = storage->m_buffer.data();
+    storage->m_size = size;
+#endif
+
+    return storage;
+  }
+
+  void MappedStorage::prefetch([[maybe_unused]] size_t offset, [[maybe_unused]] size_t size) {
+    if (!m_mapping || offset >= m_size) {
+      return;
+    }
+#if BX_PLATFORM_WINDOWS
+    WIN32_MEMORY_RANGE_ENTRY range = {m_data + offset, std::min(size, m_size - offset)};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#elif !defined(__EMSCRIPTEN__)
+    size_t begin, end;
+    getPageRange(offset, size, m_size, begin, end);
+    madvise(m_data + begin, end - begin, MADV_WILLNEED);
+#endif
+  }
+
+  void MappedStorage::release([[maybe_unused]] size_t offset, [[maybe_unused]] size_t size) {
+    if (!m_mapping || offset >= m_size) {
+      return;
+    }
+#if BX_PLATFORM_WINDOWS
+    FlushViewOfFile(m_data + offset, std::min(size, m_size - offset));
+#elif !defined(__EMSCRIPTEN__)
+    size_t begin, end;
+    getPageRange(offset, size, m_size, begin, end);
+#if BX_PLATFORM_LINUX
+    sync_file_range(m_file, off_t(begin), off_t(end - begin), SYNC_FILE_RANGE_WRITE);
+#else
+    msync(m_data + begin, end - begin, MS_ASYNC);
+#endif
+    // Only unmaps the pages from the process, the changes stay in the file (or the page cache until written)
+    madvise(m_data + begin, end - begin, MADV_DONTNEED);
+#endif
+  }
+
+} // namespace Core
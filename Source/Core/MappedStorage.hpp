@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+  /**
+   * Writable memory backed by a file, for arrays that do not fit into the main memory.
+   *
+   * The operating system loads the pages on access and writes them back when memory runs short. Code that
+   * processes the memory in order (e.g. row bands of a grid) can prefetch the next part and release the
+   * previous one, so reading and writing overlap with the computation. The file is removed when the storage is
+   * destroyed.
+   *
+   * On platforms without mmap support (Emscripten) the memory is allocated on the heap instead and the hints do
+   * nothing, so the interface stays the same.
+   */
+  class MappedStorage {
+  public:
+    ~MappedStorage();
+
+    MappedStorage(const MappedStorage&)            = delete;
+    MappedStorage& operator=(const MappedStorage&) = delete;
+
+    /**
+     * Creates the file (replacing an existing one) with size zeroed bytes and maps it. Returns nullptr if the
+     * file cannot be created or mapped.
+     */
+    static std::unique_ptr<MappedStorage> create(const std::string& path, size_t size);
+
+    uint8_t* getData() { return m_data; }
+    size_t   getSize() const { return m_size; }
+
+    /// Starts reading the range [offset, offset + size) in the background
+    void prefetch(size_t offset, size_t size);
+
+    /// Starts writing the range [offset, offset + size) back in the background and lets its pages be reclaimed
+    void release(size_t offset, size_t size);
+
+  private:
+    MappedStorage() = default;
+
+    uint8_t* m_data = nullptr;
+    size_t   m_size = 0;
+
+    void* m_mapping = nullptr; // Platform specific mapping handle
+    int   m_file    = -1;      // File descriptor (POSIX)
+
+    std::vector<uint8_t> m_buffer; // Fallback storage if the platform cannot map files
+  };
+
+} // namespace Core
@@ -0,0 +1,281 @@
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#ifndef SWE_NO_THREADS
+#include <deque>
+#endif
+
+#include "Trace.hpp"
+
+namespace Core {
+
+  int getThreadCount() {
+#ifdef SWE_NO_THREADS
+    return 1;
+#else
+    static const int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    return threadCount;
+#endif
+  }
+
+#ifndef SWE_NO_THREADS
+  // Chunks of a parallelFor call, counted down as they finish
+  struct ChunkGroup {
+    const std::function<void(int, int)>* func;
+    int                                  remaining;
+  };
+
+  struct Chunk {
+    ChunkGroup* group;
+    int         begin;
+    int         end;
+  };
+
+  /**
+   * Threads that are started once and process the chunks of all parallelFor calls.
+   *
+   * Spawning threads for every call is slow, and in the web build threads only start while the main thread
+   * yields to the browser, so they have to exist before the main thread blocks on them. Several threads can
+   * call parallelFor at the same time (e.g. the loader and the solver), the chunks are processed in order.
+   */
+  class ThreadPool {
+  public:
+    explicit ThreadPool(int threadCount) {
+      m_threads.reserve(threadCount);
+      for (int i = 0; i < threadCount; i++) {
+        m_threads.emplace_back([this] { workerLoop(); });
+      }
+    }
+
+    ~ThreadPool() {
+      {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+      }
+      m_chunkAdded.notify_all();
+      for (auto& thread : m_threads) {
+        thread.join();
+      }
+    }
+
+    void run(const std::vector<Chunk>& chunks) {
+      {
+        std::lock_guard lock(m_mutex);
+        m_chunks.insert(m_chunks.end(), chunks.begin(), chunks.end());
+      }
+      m_chunkAdded.notify_all();
+    }
+
+    // Calls func once on every pool thread, waits until all calls returned
+    void broadcast(const std::function<void()>& func) {
+      std::lock_guard  broadcastLock(m_broadcastMutex); // One broadcast at a time
+      std::unique_lock lock(m_mutex);
+
+      m_broadcast        = &func;
+      m_broadcastPending = (int)m_threads.size();
+      m_broadcastGeneration++;
+      m_chunkAdded.notify_all();
+
+      m_chunkDone.wait(lock, [this] { return m_broadcastPending == 0; });
+      m_broadcast = nullptr;
+    }
+
+    // Processes queued chunks (of any group) until all chunks of the group are done
+    void wait(ChunkGroup& group) {
+      SWE_TRACE_ZONE("Wait for Chunks");
+
+      std::unique_lock lock(m_mutex);
+      while (group.remaining > 0) {
+        if (!m_chunks.empty()) {
+          runFront(lock); // Helping out also keeps nested calls from waiting on each other
+        } else {
+          m_chunkDone.wait(lock);
+        }
+      }
+    }
+
+  private:
+    void workerLoop() {
+      uint64_t broadcastGeneration = 0;
+
+      std::unique_lock lock(m_mutex);
+      while (true) {
+        m_chunkAdded.wait(lock, [&] { return m_stopping || !m_chunks.empty() || broadcastGeneration != m_broadcastGeneration; });
+        if (m_stopping) {
+          return;
+        }
+        if (!m_chunks.empty()) {
+          runFront(lock);
+        } else {
+          broadcastGeneration = m_broadcastGeneration;
+          lock.unlock();
+          (*m_broadcast)();
+          lock.lock();
+
+          if (--m_broadcastPending == 0) {
+            m_chunkDone.notify_all();
+          }
+        }
+      }
+    }
+
+    // Has to be called with the lock held, unlocks it while the chunk runs
+    void runFront(std::unique_lock<std::mutex>& lock) {
+      Chunk chunk = m_chunks.front();
+      m_chunks.pop_front();
+
+      lock.unlock();
+      {
+        SWE_TRACE_ZONE("Parallel Chunk");
+        (*chunk.group->func)(chunk.begin, chunk.end);
+      }
+      lock.lock();
+
+      if (--chunk.group->remaining == 0) {
+        m_chunkDone.notify_all();
+      }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex               m_mutex;
+    std::condition_variable  m_chunkAdded;
+    std::condition_variable  m_chunkDone;
+    std::deque<Chunk>        m_chunks;
+    bool                     m_stopping = false;
+
+    std::mutex                   m_broadcastMutex;
+    const std::function<void()>* m_broadcast           = nullptr;
+    int                          m_broadcastPending    = 0;
+    uint64_t                     m_broadcastGeneration = 0;
+  };
+
+  static ThreadPool& getThreadPool() {
+    static ThreadPool pool(getThreadCount() - 1); // The calling thread processes a chunk as well
+    return pool;
+  }
+#endif
+
+  void initThreadPool() {
+#ifndef SWE_NO_THREADS
+    getThreadPool();
+#endif
+  }
+
+  void runOnPoolThreads([[maybe_unused]] const std::function<void()>& func) {
+#ifndef SWE_NO_THREADS
+    getThreadPool().broadcast(func);
+#endif
+  }
+
+  void parallelFor(int begin, int end, const std::function<void(int, int)>& func, int minChunk) {
+    int count = end - begin;
+    if (count <= 0) {
+      return;
+    }
+
+    int chunks = std::min(getThreadCount(), count / std::max(minChunk, 1));
+    if (chunks <= 1) {
+      func(begin, end);
+      return;
+    }
+
+#ifndef SWE_NO_THREADS
+    ThreadPool& pool = getThreadPool();
+
+    ChunkGroup         group = {&func, chunks - 1};
+    std::vector<Chunk> queued;
+    queued.reserve(chunks - 1);
+
+    int chunkSize = count / chunks;
+    int remainder = count % chunks;
+    int chunkEnd  = begin;
+    int lastBegin = begin;
+
+    for (int c = 0; c < chunks; c++) {
+      int chunkBegin = chunkEnd;
+      chunkEnd       = chunkBegin + chunkSize + (c < remainder ? 1 : 0);
+      if (c == chunks - 1) {
+        lastBegin = chunkBegin;
+      } else {
+        queued.push_back({&group, chunkBegin, chunkEnd});
+      }
+    }
+
+    pool.run(queued);
+
+    {
+      SWE_TRACE_ZONE("Parallel Chunk");
+      func(lastBegin, chunkEnd); // Last chunk runs on the calling thread
+    }
+
+    pool.wait(group);
+#endif
+  }
+
+#ifdef SWE_NO_THREADS
+  Worker::Worker(const char*) {}
+
+  Worker::~Worker() {}
+
+  void Worker::start(std::function<void()> task) { task(); }
+
+  void Worker::wait() {}
+
+  bool Worker::isBusy() { return false; }
+#else
+  Worker::Worker(const char* name):
+    m_thread([this, name] { loop(name); }) {}
+
+  Worker::~Worker() {
+    {
+      std::lock_guard lock(m_mutex);
+      m_stopping = true;
+    }
+    m_changed.notify_all();
+    m_thread.join();
+  }
+
+  void Worker::start(std::function<void()> task) {
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this] { return !m_busy; });
+    m_task = std::move(task);
+    m_busy = true;
+    lock.unlock();
+    m_changed.notify_all();
+  }
+
+  void Worker::wait() {
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this] { return !m_busy; });
+  }
+
+  bool Worker::isBusy() {
+    std::lock_guard lock(m_mutex);
+    return m_busy;
+  }
+
+  void Worker::loop(const char* name) {
+    SWE_TRACE_THREAD(name);
+    (void)name;
+
+    std::unique_lock lock(m_mutex);
+    while (true) {
+      m_changed.wait(lock, [this] { return m_stopping || m_busy; });
+      if (m_busy) {
+        lock.unlock();
+        m_task();
+        lock.lock();
+        m_task = nullptr;
+        m_busy = false;
+        m_changed.notify_all();
+      } else {
+        return;
+      }
+    }
+  }
+#endif
+
+} // namespace Core
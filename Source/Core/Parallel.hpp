@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define SWE_NO_THREADS // Web build without pthreads, everything runs on the main thread
+#endif
+
+#ifndef SWE_NO_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace Core {
+
+  /// Returns the number of threads used by parallelFor (1 if the platform has no thread support)
+  int getThreadCount();
+
+  /**
+   * Splits the range [begin, end) into contiguous chunks and calls func(chunkBegin, chunkEnd) for every chunk,
+   * one chunk per thread. The calling thread processes a chunk as well and returns once all chunks are done.
+   *
+   * @param minChunk Minimum number of elements per chunk; smaller ranges are processed on the calling thread.
+   */
+  void parallelFor(int begin, int end, const std::function<void(int, int)>& func, int minChunk = 1);
+
+  /// Starts the threads used by parallelFor, otherwise they are started by its first call
+  void initThreadPool();
+
+  /**
+   * Calls func once on every thread of parallelFor except the calling thread and returns once all calls are done,
+   * e.g. to set up state of each thread. Queued chunks are processed first.
+   */
+  void runOnPoolThreads(const std::function<void()>& func);
+
+  /**
+   * Thread that runs one task at a time in the background, e.g. the time steps of the solver while the main thread renders.
+   *
+   * Without thread support the tasks run on the calling thread when they are started.
+   */
+  class Worker {
+  public:
+    /// @param name Name of the thread in traces, has to be a string literal
+    explicit Worker(const char* name);
+    ~Worker();
+
+    Worker(const Worker&)            = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    /// Runs task in the background, waits for the previous task first
+    void start(std::function<void()> task);
+
+    /// Waits until the current task (if any) is done
+    void wait();
+
+    bool isBusy();
+
+  private:
+#ifndef SWE_NO_THREADS
+    void loop(const char* name);
+
+    std::mutex              m_mutex;
+    std::condition_variable m_changed;
+    std::function<void()>   m_task;
+    bool                    m_busy     = false;
+    bool                    m_stopping = false;
+    std::thread             m_thread; // Started last, after the members it uses
+#endif
+  };
+
+} // namespace Core
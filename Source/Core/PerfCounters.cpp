@@ -0,0 +1,234 @@
+#include "PerfCounters.hpp"
+
+#include <atomic>
+#include <bx/platform.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if BX_PLATFORM_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Parallel.hpp"
+
+namespace Core {
+
+  static constexpr int EventCount = (int)PerfEvent::Count;
+
+  static bool        s_recording = false;
+  static std::string s_error;
+  static PerfTotals  s_totals[(int)ProfileScope::Count];
+
+  // Counters of one thread, read at once through the cycles counter (the group leader)
+  struct PerfGroup {
+    int fds[EventCount]   = {-1, -1, -1, -1};
+    int slots[EventCount] = {-1, -1, -1, -1}; // Position of each event in a group read, -1 if not opened
+    int slotCount         = 0;
+  };
+
+  static std::vector<PerfGroup> s_groups; // The thread that called start first, then the threads of parallelFor
+
+  double PerfTotals::getIpc() const {
+    uint64_t cycles = counts[(int)PerfEvent::Cycles];
+    return cycles > 0 ? double(counts[(int)PerfEvent::Instructions]) / double(cycles) : 0.0;
+  }
+
+  double PerfTotals::getBytesPerSecond() const { return seconds > 0.0 ? double(counts[(int)PerfEvent::CacheMisses]) * 64.0 / seconds : 0.0; }
+
+  double PerfTotals::getVectorFraction() const {
+    uint64_t instructions = counts[(int)PerfEvent::Instructions];
+    return instructions > 0 ? double(counts[(int)PerfEvent::VectorInstructions]) / double(instructions) : 0.0;
+  }
+
+#if BX_PLATFORM_LINUX
+  static int openEvent(uint32_t type, uint64_t config, int groupFd) {
+    perf_event_attr attr = {};
+    attr.size            = sizeof(attr);
+    attr.type            = type;
+    attr.config          = config;
+    attr.disabled        = groupFd < 0 ? 1 : 0; // The group is enabled at once through its leader
+    attr.exclude_kernel  = 1;
+    attr.exclude_hv      = 1;
+    attr.read_format     = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // Counts the calling thread on any CPU
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+  }
+
+  // Opens the counters of the calling thread, returns false if the cycles counter can't be opened
+  static bool openGroup(PerfGroup& group) {
+    group.fds[(int)PerfEvent::Cycles] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (group.fds[(int)PerfEvent::Cycles] < 0) {
+      return false;
+    }
+
+    int leader                          = group.fds[(int)PerfEvent::Cycles];
+    group.slots[(int)PerfEvent::Cycles] = group.slotCount++;
+
+    group.fds[(int)PerfEvent::Instructions] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, leader);
+    group.fds[(int)PerfEvent::CacheMisses]  = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, leader);
+    if (const char* vectorEvent = std::getenv("SWE_PERF_VECTOR_EVENT")) {
+      group.fds[(int)PerfEvent::VectorInstructions] = openEvent(PERF_TYPE_RAW, std::strtoull(vectorEvent, nullptr, 0), leader);
+    }
+
+    // Group reads return the events in the order they were opened
+    for (int e = 1; e < EventCount; e++) {
+      if (group.fds[e] >= 0) {
+        group.slots[e] = group.slotCount++;
+      }
+    }
+    return true;
+  }
+#endif
+
+  bool PerfCounters::start(bool hardware) {
+    stop();
+    reset();
+    s_recording = true;
+
+    if (!hardware) {
+      return false;
+    }
+
+#if BX_PLATFORM_LINUX
+    PerfGroup group;
+    if (!openGroup(group)) {
+      int error = errno;
+      s_error   = std::string("perf_event_open failed: ") + std::strerror(error);
+      if (error == EACCES || error == EPERM) {
+        s_error += " (see /proc/sys/kernel/perf_event_paranoid)";
+      } else if (error == ENOENT || error == EOPNOTSUPP) {
+        s_error += " (no hardware counters, e.g. in a virtual machine)";
+      }
+      return false;
+    }
+    s_groups.push_back(group);
+
+    // The sweeps run on the threads of parallelFor as well, their counts are added up
+    std::mutex        mutex;
+    std::atomic<bool> failed = false;
+    runOnPoolThreads([&] {
+      PerfGroup poolGroup;
+      if (openGroup(poolGroup)) {
+        std::lock_guard lock(mutex);
+        s_groups.push_back(poolGroup);
+      } else {
+        failed = true;
+      }
+    });
+    if (failed) {
+      stop();
+      s_recording = true;
+      s_error     = "perf_event_open failed on a thread of parallelFor";
+      return false;
+    }
+
+    for (const PerfGroup& opened : s_groups) {
+      int leader = opened.fds[(int)PerfEvent::Cycles];
+      ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    return true;
+#else
+    s_error = "Hardware counters are only supported on Linux";
+    return false;
+#endif
+  }
+
+  void PerfCounters::stop() {
+#if BX_PLATFORM_LINUX
+    for (const PerfGroup& group : s_groups) {
+      for (int e = EventCount - 1; e >= 0; e--) {
+        if (group.fds[e] >= 0) {
+          close(group.fds[e]);
+        }
+      }
+    }
+#endif
+    s_groups.clear();
+    s_recording = false;
+    s_error.clear();
+  }
+
+  bool PerfCounters::isRecording() { return s_recording; }
+
+  bool PerfCounters::isAvailable(PerfEvent event) { return !s_groups.empty() && s_groups[0].slots[(int)event] >= 0; }
+
+  const std::string& PerfCounters::getError() { return s_error; }
+
+  const PerfTotals& PerfCounters::getTotals(ProfileScope scope) { return s_totals[(int)scope]; }
+
+  void PerfCounters::reset() {
+    for (PerfTotals& totals : s_totals) {
+      totals = {};
+    }
+  }
+
+  const char* PerfCounters::getName(PerfEvent event) {
+    switch (event) {
+    case PerfEvent::Cycles:
+      return "Cycles";
+    case PerfEvent::Instructions:
+      return "Instructions";
+    case PerfEvent::CacheMisses:
+      return "Cache misses";
+    case PerfEvent::VectorInstructions:
+      return "Vector instructions";
+    default:
+      return "";
+    }
+  }
+
+  bool PerfCounters::read(uint64_t counts[(int)PerfEvent::Count]) {
+    std::memset(counts, 0, EventCount * sizeof(uint64_t));
+
+#if BX_PLATFORM_LINUX
+    if (s_groups.empty()) {
+      return false;
+    }
+
+    for (const PerfGroup& group : s_groups) {
+      struct {
+        uint64_t count;
+        uint64_t timeEnabled;
+        uint64_t timeRunning;
+        uint64_t values[EventCount];
+      } values;
+
+      if (::read(group.fds[(int)PerfEvent::Cycles], &values, sizeof(values)) <= 0) {
+        return false;
+      }
+      if (values.timeRunning == 0) {
+        continue; // The thread did not run since the counters were enabled
+      }
+
+      // Scale the counts up if the group was multiplexed with other events
+      double scale = double(values.timeEnabled) / double(values.timeRunning);
+      for (int e = 0; e < EventCount; e++) {
+        if (group.slots[e] >= 0) {
+          counts[e] += uint64_t(double(values.values[group.slots[e]]) * scale);
+        }
+      }
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void PerfCounters::add(ProfileScope scope, const uint64_t counts[(int)PerfEvent::Count], double seconds) {
+    PerfTotals& totals = s_totals[(int)scope];
+    for (int e = 0; e < EventCount; e++) {
+      totals.counts[e] += counts[e];
+    }
+    totals.seconds += seconds;
+    totals.calls++;
+  }
+
+} // namespace Core
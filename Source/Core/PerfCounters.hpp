@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "Profiler.hpp"
+
+namespace Core {
+
+  enum class PerfEvent {
+    Cycles,
+    Instructions,
+    CacheMisses,        // Last level cache misses
+    VectorInstructions, // Raw event given by SWE_PERF_VECTOR_EVENT, the generic events have no equivalent
+    Count
+  };
+
+  /// Accumulated counts of a phase
+  struct PerfTotals {
+    uint64_t counts[(int)PerfEvent::Count] = {};
+    double   seconds                       = 0.0;
+    uint64_t calls                         = 0;
+
+    double getIpc() const;
+    double getBytesPerSecond() const; // Estimated from the cache misses, one cache line each
+    double getVectorFraction() const;
+  };
+
+  /**
+   * Hardware performance counters (Linux perf_event_open), accumulated per phase.
+   *
+   * The counts cover all threads the sweeps run on: the thread that called start() and the threads of parallelFor,
+   * added up. Cycles per cell are thus the cycles of all threads, and the bandwidth is the one of the whole process.
+   * Work that other threads run on the parallelFor threads while a phase is open (e.g. loading a scenario) is counted
+   * as well.
+   *
+   * Phases are the profiler scopes, timed with SWE_PERF_SCOPE. Nothing is recorded until start() is called.
+   * If the counters can't be opened (other platforms, perf_event_paranoid, virtual machines), only the time
+   * and number of calls of each phase are recorded and getError() describes why.
+   */
+  class PerfCounters {
+  public:
+    /// Starts recording on the calling thread and the parallelFor threads, returns false if hardware counters are not available (phases are timed anyway)
+    static bool start(bool hardware = true);
+    static void stop();
+
+    static bool isRecording();
+    static bool isAvailable(PerfEvent event);
+
+    static const std::string& getError();
+
+    static const PerfTotals& getTotals(ProfileScope scope);
+    static void              reset();
+
+    static const char* getName(PerfEvent event);
+
+    /// Reads the current counter values summed over all counted threads, returns false if hardware counters are not available
+    static bool read(uint64_t counts[(int)PerfEvent::Count]);
+    static void add(ProfileScope scope, const uint64_t counts[(int)PerfEvent::Count], double seconds);
+  };
+
+  /// Adds the counts between construction and destruction to a phase if recording
+  class PerfScope {
+  public:
+    explicit PerfScope(ProfileScope scope):
+      m_scope(scope),
+      m_recording(PerfCounters::isRecording()) {
+      if (m_recording) {
+        PerfCounters::read(m_counts);
+        m_start = std::chrono::steady_clock::now();
+      }
+    }
+
+    ~PerfScope() {
+      if (!m_recording) {
+        return;
+      }
+
+      auto     end = std::chrono::steady_clock::now();
+      uint64_t counts[(int)PerfEvent::Count];
+      PerfCounters::read(counts);
+      for (int e = 0; e < (int)PerfEvent::Count; e++) {
+        counts[e] -= m_counts[e];
+      }
+      PerfCounters::add(m_scope, counts, std::chrono::duration<double>(end - m_start).count());
+    }
+
+    PerfScope(const PerfScope&)            = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+  private:
+    ProfileScope                          m_scope;
+    bool                                  m_recording;
+    uint64_t                              m_counts[(int)PerfEvent::Count] = {};
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+} // namespace Core
+
+/// Counts the rest of the enclosing block, e.g. SWE_PERF_SCOPE(XSweep)
+#define SWE_PERF_SCOPE(scope) Core::PerfScope SWE_PROFILE_CONCAT(perfScope, __LINE__)(Core::ProfileScope::scope)
@@ -0,0 +1,102 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace Core {
+
+  struct ProfileFrame {
+    std::atomic<uint32_t> times[(int)ProfileScope::Count];     // Microseconds
+    std::atomic<double>   counts[(int)ProfileCounter::Count];
+    std::atomic<uint32_t> frameTime;                            // Microseconds
+  };
+
+  static ProfileFrame          s_frames[Profiler::HistorySize + 1]; // Closed frames and the current one
+  static std::atomic<uint32_t> s_currentFrame = 0;
+  static std::atomic<uint32_t> s_closedFrames = 0;
+
+  static ProfileFrame& getFrame(uint32_t frame) { return s_frames[frame % (Profiler::HistorySize + 1)]; }
+
+  void Profiler::addTime(ProfileScope scope, uint32_t microseconds) {
+    getFrame(s_currentFrame.load(std::memory_order_acquire)).times[(int)scope].fetch_add(microseconds, std::memory_order_relaxed);
+  }
+
+  void Profiler::addCount(ProfileCounter counter, double value) {
+    getFrame(s_currentFrame.load(std::memory_order_acquire)).counts[(int)counter].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  void Profiler::endFrame() {
+    static auto last = std::chrono::steady_clock::now();
+
+    auto now     = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - last);
+    last         = now;
+
+    uint32_t frame = s_currentFrame.load(std::memory_order_relaxed);
+    getFrame(frame).frameTime.store((uint32_t)elapsed.count(), std::memory_order_relaxed);
+
+    // Clear the oldest slot before it becomes the current one
+    ProfileFrame& next = getFrame(frame + 1);
+    for (auto& time : next.times) {
+      time.store(0, std::memory_order_relaxed);
+    }
+    for (auto& count : next.counts) {
+      count.store(0.0, std::memory_order_relaxed);
+    }
+    next.frameTime.store(0, std::memory_order_relaxed);
+
+    s_currentFrame.store(frame + 1, std::memory_order_release);
+    if (s_closedFrames.load(std::memory_order_relaxed) < HistorySize) {
+      s_closedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  template <class Get>
+  static int copyHistory(float* values, int n, Get get) {
+    uint32_t current = s_currentFrame.load(std::memory_order_acquire);
+    int      count   = std::min(n, (int)s_closedFrames.load(std::memory_order_relaxed));
+
+    for (int k = 0; k < count; k++) {
+      values[k] = get(getFrame(current - count + k));
+    }
+    return count;
+  }
+
+  int Profiler::getHistory(ProfileScope scope, float* values, int n) {
+    return copyHistory(values, n, [=](const ProfileFrame& frame) { return frame.times[(int)scope].load(std::memory_order_relaxed) * 0.001f; });
+  }
+
+  int Profiler::getHistory(ProfileCounter counter, float* values, int n) {
+    return copyHistory(values, n, [=](const ProfileFrame& frame) { return (float)frame.counts[(int)counter].load(std::memory_order_relaxed); });
+  }
+
+  int Profiler::getFrameTimes(float* values, int n) {
+    return copyHistory(values, n, [](const ProfileFrame& frame) { return frame.frameTime.load(std::memory_order_relaxed) * 0.001f; });
+  }
+
+  const char* Profiler::getName(ProfileScope scope) {
+    switch (scope) {
+    case ProfileScope::GhostLayer:
+      return "Ghost layer";
+    case ProfileScope::XSweep:
+      return "X-sweep";
+    case ProfileScope::YSweep:
+      return "Y-sweep";
+    case ProfileScope::BlockedSteps:
+      return "Blocked steps";
+    case ProfileScope::MaxTimeStep:
+      return "Max time step";
+    case ProfileScope::UpdateGrid:
+      return "Update grid";
+    case ProfileScope::TextureUpload:
+      return "Texture upload";
+    case ProfileScope::ImGui:
+      return "ImGui";
+    case ProfileScope::Frame:
+      return "bgfx::frame";
+    default:
+      return "";
+    }
+  }
+
+} // namespace Core
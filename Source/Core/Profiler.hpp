@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Core {
+
+  enum class ProfileScope { GhostLayer, XSweep, YSweep, BlockedSteps, MaxTimeStep, UpdateGrid, TextureUpload, ImGui, Frame, Count };
+
+  enum class ProfileCounter {
+    Cells,         // Cells updated by the solver
+    SimulatedTime, // Simulated seconds
+    Count
+  };
+
+  /**
+   * Time spent per phase over the last frames.
+   *
+   * Every frame has a slot in a ring buffer holding an atomic accumulator per scope and counter,
+   * so timings can be recorded from any thread without locks. endFrame() closes the current slot
+   * (and measures the wall time of the frame); only closed frames are part of the history.
+   */
+  class Profiler {
+  public:
+    static constexpr int HistorySize = 240; // Closed frames kept
+
+    static void addTime(ProfileScope scope, uint32_t microseconds);
+    static void addCount(ProfileCounter counter, double value);
+    static void endFrame();
+
+    /**
+     * Copies the values of the last n closed frames into values, oldest first.
+     * Times are in milliseconds.
+     *
+     * @return the number of frames copied (fewer than n at startup).
+     */
+    static int getHistory(ProfileScope scope, float* values, int n);
+    static int getHistory(ProfileCounter counter, float* values, int n);
+    static int getFrameTimes(float* values, int n);
+
+    static const char* getName(ProfileScope scope);
+  };
+
+  /// Adds the time between construction and destruction to a scope of the current frame
+  class ProfileTimer {
+  public:
+    explicit ProfileTimer(ProfileScope scope):
+      m_scope(scope),
+      m_start(std::chrono::steady_clock::now()) {}
+
+    ~ProfileTimer() {
+      auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+      Profiler::addTime(m_scope, (uint32_t)elapsed.count());
+    }
+
+    ProfileTimer(const ProfileTimer&)            = delete;
+    ProfileTimer& operator=(const ProfileTimer&) = delete;
+
+  private:
+    ProfileScope                          m_scope;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+} // namespace Core
+
+#define SWE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SWE_PROFILE_CONCAT(a, b)      SWE_PROFILE_CONCAT_IMPL(a, b)
+
+/// Times the rest of the enclosing block, e.g. SWE_PROFILE_SCOPE(XSweep)
+#define SWE_PROFILE_SCOPE(scope) Core::ProfileTimer SWE_PROFILE_CONCAT(profileTimer, __LINE__)(Core::ProfileScope::scope)
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace Core {
+
+  /**
+   * Progress and cancellation of a task that runs on another thread, e.g. loading a scenario.
+   *
+   * The owner divides the task into stages (beginStage). The loops of a stage announce their work in units
+   * (addWork) before starting it and report finished units (advance) from any thread, which also tells them
+   * whether to stop early because the task was cancelled.
+   */
+  class Progress {
+  public:
+    /// Finishes the current stage and starts the next one, which ends at fraction end (0 to 1) of the task
+    void beginStage(float end) {
+      m_total = 0;
+      m_done  = 0;
+      m_stageBegin.store(m_stageEnd.load());
+      m_stageEnd = end;
+    }
+
+    /// Adds units of work to the current stage
+    void addWork(int64_t units) { m_total += units; }
+
+    /// Marks units of work of the current stage as done, returns false if the task was cancelled
+    bool advance(int64_t units = 1) {
+      m_done += units;
+      return !m_cancelled;
+    }
+
+    /// Fraction of the task that is done, never decreases (work can be added while a stage runs)
+    float getFraction() const {
+      float   begin    = m_stageBegin;
+      float   end      = m_stageEnd;
+      int64_t total    = m_total;
+      int64_t done     = std::min<int64_t>(m_done, total);
+      float   fraction = total > 0 ? begin + (end - begin) * float(done) / float(total) : begin;
+
+      float reported = m_reported;
+      while (fraction > reported && !m_reported.compare_exchange_weak(reported, fraction)) {
+      }
+      return std::max(fraction, reported);
+    }
+
+    void cancel() { m_cancelled = true; }
+    bool isCancelled() const { return m_cancelled; }
+
+  private:
+    std::atomic<float>   m_stageBegin = 0.0f;
+    std::atomic<float>   m_stageEnd   = 0.0f;
+    std::atomic<int64_t> m_total      = 0;
+    std::atomic<int64_t> m_done       = 0;
+    std::atomic<bool>    m_cancelled  = false;
+
+    mutable std::atomic<float> m_reported = 0.0f;
+  };
+
+  /// Progress::addWork of an optional progress
+  inline void addWork(Progress* progress, int64_t units) {
+    if (progress) {
+      progress->addWork(units);
+    }
+  }
+
+  /// Progress::advance of an optional progress, a task without one is never cancelled
+  inline bool advance(Progress* progress, int64_t units = 1) { return !progress || progress->advance(units); }
+
+} // namespace Core
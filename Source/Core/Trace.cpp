@@ -0,0 +1,196 @@
+#ifdef ENABLE_TRACING
+
+#include "Trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#endif
+
+namespace Core {
+
+  struct TraceEvent {
+    const char* name;
+    int64_t     start; // Nanoseconds
+    int64_t     end;
+  };
+
+  struct ThreadBuffer {
+    std::mutex              mutex; // Only contended while a recording is started or written
+    std::vector<TraceEvent> events;
+    std::string             name;
+    int                     id    = 0;
+    bool                    named = false; // Named buffers are only reused by threads of the same name
+    bool                    owned = false; // Held by a running thread
+  };
+
+  static std::atomic<bool>                          s_recording = false;
+  static std::string                                s_path      = Trace::DefaultPath;
+  static std::mutex                                 s_buffersMutex;
+  static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+  static std::vector<ThreadBuffer*>                 s_freeBuffers;
+
+  // Makes a buffer available to other threads, has to be called with s_buffersMutex locked
+  static void releaseThreadBuffer(ThreadBuffer* buffer) {
+    buffer->owned = false;
+    if (!buffer->named) {
+      s_freeBuffers.push_back(buffer);
+    }
+  }
+
+  // Releases the buffer when its thread exits
+  struct ThreadBufferHandle {
+    ThreadBuffer* buffer = nullptr;
+
+    ~ThreadBufferHandle() {
+      if (buffer) {
+        std::lock_guard lock(s_buffersMutex);
+        releaseThreadBuffer(buffer);
+      }
+    }
+  };
+
+  static thread_local ThreadBufferHandle s_threadBuffer;
+
+  // Has to be called with s_buffersMutex locked
+  static ThreadBuffer* createThreadBuffer() {
+    auto& buffer = s_buffers.emplace_back(std::make_unique<ThreadBuffer>());
+    buffer->id   = (int)s_buffers.size();
+    buffer->name = "Worker " + std::to_string(buffer->id);
+    return buffer.get();
+  }
+
+  static ThreadBuffer& getThreadBuffer() {
+    if (s_threadBuffer.buffer) {
+      return *s_threadBuffer.buffer;
+    }
+
+    std::lock_guard lock(s_buffersMutex);
+    if (!s_freeBuffers.empty()) {
+      s_threadBuffer.buffer = s_freeBuffers.back();
+      s_freeBuffers.pop_back();
+    } else {
+      s_threadBuffer.buffer = createThreadBuffer();
+    }
+    s_threadBuffer.buffer->owned = true;
+    return *s_threadBuffer.buffer;
+  }
+
+  void Trace::start(const std::string& path) {
+    std::lock_guard lock(s_buffersMutex);
+    for (auto& buffer : s_buffers) {
+      std::lock_guard bufferLock(buffer->mutex);
+      buffer->events.clear();
+    }
+    s_path = path;
+    s_recording.store(true, std::memory_order_release);
+  }
+
+  bool Trace::stop() {
+    s_recording.store(false, std::memory_order_release);
+
+    std::lock_guard lock(s_buffersMutex);
+
+    std::FILE* file = std::fopen(s_path.c_str(), "w");
+    if (!file) {
+      return false;
+    }
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"SWE\"}}");
+
+    for (auto& buffer : s_buffers) {
+      std::lock_guard bufferLock(buffer->mutex);
+      std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", buffer->id, buffer->name.c_str());
+
+      // Complete events with microsecond timestamps
+      for (const TraceEvent& event : buffer->events) {
+        std::fprintf(
+          file,
+          ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+          event.name,
+          buffer->id,
+          event.start * 1e-3,
+          (event.end - event.start) * 1e-3
+        );
+      }
+
+      buffer->events.clear();
+      buffer->events.shrink_to_fit();
+    }
+
+    std::fprintf(file, "\n]}\n");
+    bool ok = std::fclose(file) == 0;
+
+#ifdef __EMSCRIPTEN__
+    // The file only exists in the virtual file system, hand it to the browser as a download
+    if (ok) {
+      EM_ASM_ARGS(
+        {
+          const path = UTF8ToString($0);
+          const link = document.createElement('a');
+          link.href = URL.createObjectURL(new Blob([FS.readFile(path)], {type : 'application/json'}));
+          link.download = path.split('/').pop();
+          link.click();
+        },
+        s_path.c_str()
+      );
+    }
+#endif
+
+    return ok;
+  }
+
+  bool Trace::isRecording() { return s_recording.load(std::memory_order_relaxed); }
+
+  const std::string& Trace::getPath() { return s_path; }
+
+  void Trace::setThreadName(const char* name) {
+    std::lock_guard lock(s_buffersMutex);
+
+    ThreadBuffer* current = s_threadBuffer.buffer;
+    if (current && current->named && current->name == name) {
+      return;
+    }
+
+    // A named thread gets the track of a finished thread of the same name or a new one, an unnamed buffer may
+    // hold zones of other threads. There are only as many tracks of a name as threads of it ran at once.
+    if (current) {
+      releaseThreadBuffer(current);
+    }
+    ThreadBuffer* buffer = nullptr;
+    for (auto& candidate : s_buffers) {
+      if (candidate->named && !candidate->owned && candidate->name == name) {
+        buffer = candidate.get();
+        break;
+      }
+    }
+    if (!buffer) {
+      buffer        = createThreadBuffer();
+      buffer->name  = name;
+      buffer->named = true;
+    }
+    buffer->owned         = true;
+    s_threadBuffer.buffer = buffer;
+  }
+
+  int64_t Trace::now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+  }
+
+  void Trace::addZone(const char* name, int64_t start, int64_t end) {
+    ThreadBuffer&   buffer = getThreadBuffer();
+    std::lock_guard lock(buffer.mutex);
+    buffer.events.push_back({name, start, end});
+  }
+
+} // namespace Core
+
+#endif
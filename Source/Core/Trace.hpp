@@ -0,0 +1,78 @@
+#pragma once
+
+#ifdef ENABLE_TRACING
+
+#include <cstdint>
+#include <string>
+
+namespace Core {
+
+  /**
+   * Timeline of named zones on all threads, written in the Chrome trace event format.
+   *
+   * The file can be opened in chrome://tracing or https://ui.perfetto.dev. Every thread appends to its own
+   * buffer, so recording does not synchronise the threads; buffers of finished threads are reused by new ones
+   * (e.g. the threads of successive scenario loads share a track). Zones are only recorded between start() and stop().
+   */
+  class Trace {
+  public:
+    static constexpr const char* DefaultPath = "swe-trace.json";
+
+    /// Starts a new recording that is written to path by stop()
+    static void start(const std::string& path);
+
+    /// Stops the recording and writes it, returns false if the file could not be written
+    static bool stop();
+
+    static bool isRecording();
+
+    /// Path of the current or last recording, DefaultPath if there was none
+    static const std::string& getPath();
+
+    /// Names the track of the calling thread
+    static void setThreadName(const char* name);
+
+    /// Nanoseconds since the start of the program
+    static int64_t now();
+
+    /// Adds a zone of the calling thread, name has to be a string literal (or outlive the recording)
+    static void addZone(const char* name, int64_t start, int64_t end);
+  };
+
+  /// Records a zone from construction to destruction if a recording is running
+  class TraceZone {
+  public:
+    explicit TraceZone(const char* name):
+      m_name(Trace::isRecording() ? name : nullptr),
+      m_start(m_name ? Trace::now() : 0) {}
+
+    ~TraceZone() {
+      if (m_name) {
+        Trace::addZone(m_name, m_start, Trace::now());
+      }
+    }
+
+    TraceZone(const TraceZone&)            = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+  private:
+    const char* m_name;
+    int64_t     m_start;
+  };
+
+} // namespace Core
+
+#define SWE_TRACE_CONCAT_IMPL(a, b) a##b
+#define SWE_TRACE_CONCAT(a, b)      SWE_TRACE_CONCAT_IMPL(a, b)
+
+/// Traces the rest of the enclosing block, e.g. SWE_TRACE_ZONE("Load Scenario")
+#define SWE_TRACE_ZONE(name) Core::TraceZone SWE_TRACE_CONCAT(traceZone, __LINE__)(name)
+
+#define SWE_TRACE_THREAD(name) Core::Trace::setThreadName(name)
+
+#else
+
+#define SWE_TRACE_ZONE(name)   ((void)0)
+#define SWE_TRACE_THREAD(name) ((void)0)
+
+#endif
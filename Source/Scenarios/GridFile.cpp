@@ -0,0 +1,105 @@
+#include "GridFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Core/Parallel.hpp"
+#include "Core/Trace.hpp"
+
+bool Scenarios::GridFile::load(const std::string& filename, int minNX, int minNY) {
+  SWE_TRACE_ZONE("Load Grid File");
+
+  // Mappings are cached, so switching back to a scenario doesn't read the file again
+  file_ = Core::MappedFile::openShared(filename);
+  if (!file_ || file_->getSize() < sizeof(FileHeader))
+    return false;
+
+  if (std::memcmp(file_->getData(), TiledMagic, sizeof(TiledMagic)) == 0) {
+    return loadTiled(minNX, minNY);
+  }
+
+  std::memcpy(&header_, file_->getData(), sizeof(FileHeader));
+  domain_ = header_;
+
+  // Validate header against the file size before handing out a view of the data
+  if (header_.nX < 2 || header_.nY < 2 || !(header_.dx > 0.0) || !(header_.dy > 0.0))
+    return false;
+  if ((file_->getSize() - sizeof(FileHeader)) / sizeof(float) / header_.nX < header_.nY)
+    return false;
+
+  // Non-owning view of the mapped data (the header size keeps the floats aligned)
+  data_ = Float2D<const float>(header_.nY, header_.nX, reinterpret_cast<const float*>(file_->getData() + sizeof(FileHeader)));
+
+  return true;
+}
+
+bool Scenarios::GridFile::loadTiled(int minNX, int minNY) {
+  const uint8_t* file = file_->getData();
+  size_t         size = file_->getSize();
+
+  TiledFileHeader tiledHeader;
+  if (size < sizeof(TiledFileHeader))
+    return false;
+  std::memcpy(&tiledHeader, file, sizeof(TiledFileHeader));
+
+  if (tiledHeader.version != TiledVersion || tiledHeader.tileSize == 0 || tiledHeader.levelCount == 0)
+    return false;
+  if ((size - sizeof(TiledFileHeader)) / sizeof(LevelHeader) < tiledHeader.levelCount)
+    return false;
+
+  // Pick the coarsest level that still provides the requested resolution
+  LevelHeader level;
+  std::memcpy(&level, file + sizeof(TiledFileHeader), sizeof(LevelHeader));
+  domain_ = level.grid;
+  for (uint32_t l = 1; l < tiledHeader.levelCount && minNX > 0 && minNY > 0; l++) {
+    LevelHeader coarser;
+    std::memcpy(&coarser, file + sizeof(TiledFileHeader) + l * sizeof(LevelHeader), sizeof(LevelHeader));
+    if ((int)coarser.grid.nX < minNX || (int)coarser.grid.nY < minNY)
+      break;
+    level = coarser;
+  }
+
+  header_            = level.grid;
+  const uint32_t n   = tiledHeader.tileSize;
+  const size_t   nX  = header_.nX;
+  const size_t   nY  = header_.nY;
+  const size_t   tsX = level.tilesX;
+  const size_t   tsY = level.tilesY;
+
+  if (nX < 2 || nY < 2 || !(header_.dx > 0.0) || !(header_.dy > 0.0))
+    return false;
+  if (domain_.nX < 2 || domain_.nY < 2 || !(domain_.dx > 0.0) || !(domain_.dy > 0.0))
+    return false;
+  if (tsX != (nX + n - 1) / n || tsY != (nY + n - 1) / n)
+    return false;
+  if (level.tileIndexOffset > size || (size - level.tileIndexOffset) / sizeof(uint64_t) / tsX < tsY)
+    return false;
+
+  std::vector<uint64_t> tileIndex(tsX * tsY);
+  std::memcpy(tileIndex.data(), file + level.tileIndexOffset, tileIndex.size() * sizeof(uint64_t));
+
+  const size_t tileBytes = size_t(n) * n * sizeof(float);
+  for (uint64_t offset : tileIndex) {
+    if (offset % alignof(float) != 0 || offset > size || size - offset < tileBytes)
+      return false;
+  }
+
+  // Assemble the level from its tiles (only the pages of these tiles are touched)
+  storage_.resize(nX * nY);
+  Core::parallelFor(0, (int)tsY, [&](int tyBegin, int tyEnd) {
+    for (size_t ty = tyBegin; ty < (size_t)tyEnd; ty++) {
+      size_t rows = std::min<size_t>(n, nY - ty * n);
+      for (size_t tx = 0; tx < tsX; tx++) {
+        size_t       cols = std::min<size_t>(n, nX - tx * n);
+        const float* tile = reinterpret_cast<const float*>(file + tileIndex[ty * tsX + tx]);
+        for (size_t r = 0; r < rows; r++) {
+          std::memcpy(&storage_[(ty * n + r) * nX + tx * n], tile + r * n, cols * sizeof(float));
+        }
+      }
+    }
+  });
+
+  data_ = Float2D<const float>(header_.nY, header_.nX, storage_.data());
+
+  return true;
+}
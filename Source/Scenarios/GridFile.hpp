@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Core/MappedFile.hpp"
+#include "Types/Float2D.hpp"
+
+namespace Scenarios {
+
+  /**
+   * Gridded float data (bathymetry or displacement) loaded from a binary data file.
+   *
+   * Two layouts are supported, distinguished by the magic number at the start of the file:
+   * - Flat (version 1): FileHeader followed by a dense nX * nY float array (row-major).
+   * - Tiled (version 2): TiledFileHeader, a LevelHeader per pyramid level and for each level
+   *   a tile index (one file offset per tile) pointing to tileSize * tileSize float tiles.
+   *   Level 0 is the full resolution, every further level halves the number of cells per axis
+   *   (rounding up, the last row/column of an odd size is replicated) and doubles the cell size,
+   *   starting at the same lower corner. A padded level extends past the domain of level 0, which stays
+   *   the domain of the data (see getDomain). Only the tiles of the selected level are read.
+   *
+   * Both layouts are written by Scripts/convert_netcdf.py.
+   */
+  class GridFile {
+  public:
+    struct FileHeader {
+      uint32_t nX;
+      uint32_t nY;
+      double   originX;
+      double   originY;
+      double   dx;
+      double   dy;
+    };
+
+    struct TiledFileHeader {
+      char     magic[4]; // TiledMagic
+      uint32_t version;  // TiledVersion
+      uint32_t tileSize;
+      uint32_t levelCount;
+    };
+
+    struct LevelHeader {
+      FileHeader grid;
+      uint32_t   tilesX;
+      uint32_t   tilesY;
+      uint64_t   tileIndexOffset; ///< File offset of tilesX * tilesY uint64_t tile offsets (row-major)
+    };
+
+    static constexpr char     TiledMagic[4] = {'S', 'W', 'E', 'T'};
+    static constexpr uint32_t TiledVersion  = 2;
+
+    static_assert(sizeof(FileHeader) % alignof(float) == 0);
+
+    /**
+     * Loads a data file.
+     *
+     * For tiled files the coarsest level with at least minNX x minNY cells is selected
+     * (the full resolution if no level is fine enough or the minimum is 0).
+     *
+     * @return false if the file is missing or malformed.
+     */
+    bool load(const std::string& filename, int minNX = 0, int minNY = 0);
+
+    /// Returns the grid description of the loaded data (for tiled files of the selected level)
+    const FileHeader& getHeader() const { return header_; }
+
+    /// Returns the grid description of the full resolution data, whose extent is the domain of every level
+    const FileHeader& getDomain() const { return domain_; }
+
+    /// Returns the loaded data, indexed as data[j][i]
+    const Float2D<const float>& getData() const { return data_; }
+
+    /// Returns the mapping the data was loaded from
+    const Core::MappedFile& getFile() const { return *file_; }
+
+  private:
+    bool loadTiled(int minNX, int minNY);
+
+    std::shared_ptr<const Core::MappedFile> file_;
+    std::vector<float>                      storage_; // Assembled level of a tiled file
+
+    FileHeader           header_{};
+    FileHeader           domain_{};
+    Float2D<const float> data_;
+  };
+
+} // namespace Scenarios
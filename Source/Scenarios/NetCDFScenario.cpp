@@ -1,12 +1,93 @@
 #ifdef ENABLE_NETCDF
 #include "NetCDFScenario.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <netcdf>
+#include <vector>
+
+#include "Core/Parallel.hpp"
+#include "Core/Trace.hpp"
+
+/**
+ * Reads every stride-th value of a 2D (y, x) variable into data, starting half a stride into the variable
+ * (see getStridedOrigin). Each axis gets ceil(n / stride) values, the last one is clamped to the last value of the
+ * variable if the stride does not divide n, so the values cover the whole variable.
+ *
+ * The hyperslab is read in bands of whole chunk rows, so each chunk is decompressed at most once
+ * and cells between the sampled rows and columns are never copied. Progress advances by the rows of each band.
+ *
+ * @return false if progress was cancelled before all bands were read.
+ */
+static bool readStrided(const netCDF::NcVar& var, int nX, int nY, int strideX, int strideY, Float2D<RealType>& data, Core::Progress* progress) {
+  int outNX = (nX + strideX - 1) / strideX;
+  int outNY = (nY + strideY - 1) / strideY;
+  data      = Float2D<RealType>(outNY, outNX);
+
+  Core::addWork(progress, outNY);
+
+  // Values whose stride position lies within the variable, the clamped last one is read separately
+  int readNX = (nX - 1 - strideX / 2) / strideX + 1;
+  int readNY = (nY - 1 - strideY / 2) / strideY + 1;
+
+  // Reads count rows from y on (stepY apart) into the output rows from row on
+  auto readRows = [&](int y, int count, int stepY, int row) {
+    std::ptrdiff_t step = stepY;
+    var.getVar({(size_t)y, (size_t)(strideX / 2)}, {(size_t)count, (size_t)readNX}, {step, (std::ptrdiff_t)strideX}, {(std::ptrdiff_t)outNX, 1}, data[row]);
+    if (readNX < outNX) {
+      var.getVar({(size_t)y, (size_t)(nX - 1)}, {(size_t)count, 1}, {step, 1}, {(std::ptrdiff_t)outNX, 1}, data[row] + readNX);
+    }
+  };
+
+  netCDF::NcVar::ChunkMode chunkMode;
+  std::vector<size_t>      chunkSizes;
+  var.getChunkingParameters(chunkMode, chunkSizes);
+  int chunkRows = (chunkMode == netCDF::NcVar::nc_CHUNKED && chunkSizes.size() == 2) ? std::max((int)chunkSizes[0], 1) : nY;
+
+  int row = 0;
+  while (row < readNY) {
+    // Collect all output rows that lie in the same band of chunks
+    int y     = strideY / 2 + row * strideY;
+    int band  = y / chunkRows;
+    int count = 1;
+    while (row + count < readNY && (strideY / 2 + (row + count) * strideY) / chunkRows == band) {
+      count++;
+    }
+
+    readRows(y, count, strideY, row);
+    row += count;
+
+    if (!Core::advance(progress, count)) {
+      return false;
+    }
+  }
+  if (readNY < outNY) {
+    readRows(nY - 1, 1, 1, outNY - 1);
+  }
+  return Core::advance(progress, outNY - readNY);
+}
+
+/**
+ * Returns the lower edge of the first cell of values read by readStrided from a variable whose first cell starts at
+ * lower. Each strided cell is centered at its sampled value, which is half a cell off the center of the stride
+ * values it replaces for even strides.
+ */
+static RealType getStridedOrigin(double lower, RealType cellSize, int stride) {
+  return RealType(lower + (stride / 2 + 0.5 - 0.5 * stride) * cellSize);
+}
 
-Scenarios::NetCDFScenario::NetCDFScenario(const std::string& bathymetryFile, const std::string& displacementFile, BoundaryType boundaryType):
+Scenarios::NetCDFScenario::NetCDFScenario(
+  const std::string& bathymetryFile,
+  const std::string& displacementFile,
+  BoundaryType       boundaryType,
+  int                nx,
+  int                ny,
+  Core::Progress*    progress
+):
   boundaryType_(boundaryType) {
+  SWE_TRACE_ZONE("Read NetCDF Files");
+
   // Bathymetry file
   try {
 #ifndef NDEBUG
@@ -53,9 +134,22 @@ Scenarios::NetCDFScenario::NetCDFScenario(const std::string& bathymetryFile, con
     originX_ = boundaryPos_[0];
     originY_ = boundaryPos_[2];
 
-    b_ = Float2D<RealType>(bNY_, bNX_);
+    // Only read as many cells as the simulation grid can resolve
+    int strideX = nx > 0 ? std::max(bNX_ / nx, 1) : 1;
+    int strideY = ny > 0 ? std::max(bNY_ / ny, 1) : 1;
 
-    bVar.getVar(b_.getData());
+    if (!readStrided(bVar, bNX_, bNY_, strideX, strideY, b_, progress)) {
+      success_ = false;
+      return;
+    }
+
+    // The strided cells cover the domain, positions outside of them belong to the first or last one
+    originX_ = getStridedOrigin(boundaryPos_[0], bDX_, strideX);
+    originY_ = getStridedOrigin(boundaryPos_[2], bDY_, strideY);
+    bNX_     = b_.getRows();
+    bNY_     = b_.getCols();
+    bDX_ *= strideX;
+    bDY_ *= strideY;
 
   } catch (netCDF::exceptions::NcException& e) {
     // std::cerr << e.what() << std::endl;
@@ -119,9 +213,23 @@ Scenarios::NetCDFScenario::NetCDFScenario(const std::string& bathymetryFile, con
     dOriginX_ = dBoundaryPos_[0];
     dOriginY_ = dBoundaryPos_[2];
 
-    d_ = Float2D<RealType>(dNY_, dNX_);
+    // Same as for the bathymetry, based on the cell size of the simulation grid
+    int strideX = nx > 0 ? std::max((int)((boundaryPos_[1] - boundaryPos_[0]) / nx / dDX_), 1) : 1;
+    int strideY = ny > 0 ? std::max((int)((boundaryPos_[3] - boundaryPos_[2]) / ny / dDY_), 1) : 1;
+    strideX     = std::min(strideX, dNX_);
+    strideY     = std::min(strideY, dNY_);
 
-    dVar.getVar(d_.getData());
+    if (!readStrided(dVar, dNX_, dNY_, strideX, strideY, d_, progress)) {
+      success_ = false;
+      return;
+    }
+
+    dOriginX_ = getStridedOrigin(dBoundaryPos_[0], dDX_, strideX);
+    dOriginY_ = getStridedOrigin(dBoundaryPos_[2], dDY_, strideY);
+    dNX_      = d_.getRows();
+    dNY_      = d_.getCols();
+    dDX_ *= strideX;
+    dDY_ *= strideY;
 
   } catch (netCDF::exceptions::NcException& e) {
     // std::cerr << e.what() << std::endl;
@@ -131,49 +239,83 @@ Scenarios::NetCDFScenario::NetCDFScenario(const std::string& bathymetryFile, con
 }
 
 RealType Scenarios::NetCDFScenario::getBathymetryBeforeDisplacement(RealType x, RealType y) const {
-  if (x < boundaryPos_[0] || x > boundaryPos_[1] || y < boundaryPos_[2] || y > boundaryPos_[3]) {
+  int i = getCellIndex(x, boundaryPos_[0], boundaryPos_[1], originX_, bDX_, bNX_);
+  int j = getCellIndex(y, boundaryPos_[2], boundaryPos_[3], originY_, bDY_, bNY_);
+
+  if (i < 0 || j < 0) {
     return RealType(0.0); // Will be later replaced by a boundary condition
   }
 
-  // Determine indices
-  int i = std::round((x - originX_) / bDX_ - 0.5);
-  int j = std::round((y - originY_) / bDY_ - 0.5);
-
-  assert(i >= 0 && i < bNX_);
-  assert(j >= 0 && j < bNY_);
-
-  RealType b = b_[j][i];
+  return clampBathymetry(b_[j][i]);
+}
 
-  // Clamp the bathymetry to a minimum of 20m
-  if (std::abs(b) < 20.0) {
-    b = RealType(20.0 * std::copysign(1.0, b));
+RealType Scenarios::NetCDFScenario::getDisplacement(RealType x, RealType y) const {
+  if (noDisplacement_) {
+    return RealType(0.0);
   }
 
-  return b;
-}
+  int i = getCellIndex(x, dBoundaryPos_[0], dBoundaryPos_[1], dOriginX_, dDX_, dNX_);
+  int j = getCellIndex(y, dBoundaryPos_[2], dBoundaryPos_[3], dOriginY_, dDY_, dNY_);
 
-RealType Scenarios::NetCDFScenario::getDisplacement(RealType x, RealType y) const {
-  if (noDisplacement_ || x < dBoundaryPos_[0] || x > dBoundaryPos_[1] || y < dBoundaryPos_[2] || y > dBoundaryPos_[3]) {
+  if (i < 0 || j < 0) {
     return RealType(0.0); // No displacement
   }
 
-  // Determine indices
-  int i = std::round((x - dOriginX_) / dDX_ - 0.5);
-  int j = std::round((y - dOriginY_) / dDY_ - 0.5);
-
-  // Handle edge cases
-  if (x == dBoundaryPos_[0])
-    i = 0;
-  if (x == dBoundaryPos_[1])
-    i = dNX_ - 1;
-  if (y == dBoundaryPos_[2])
-    j = 0;
-  if (y == dBoundaryPos_[3])
-    j = dNY_ - 1;
+  return d_[j][i];
+}
 
-  assert(i >= 0 && i < dNX_);
-  assert(j >= 0 && j < dNY_);
+void Scenarios::NetCDFScenario::sampleGrid(
+  RealType           offsetX,
+  RealType           offsetY,
+  RealType           dx,
+  RealType           dy,
+  int                nx,
+  int                ny,
+  Float2D<RealType>& h,
+  Float2D<RealType>& hu,
+  Float2D<RealType>& hv,
+  Float2D<RealType>& b,
+  Core::Progress*    progress
+) const {
+  SWE_TRACE_ZONE("Sample Grid");
+
+  // The grid is axis-aligned, so the data indices only depend on the column or the row respectively
+  std::vector<int> bI(nx + 2), dI(nx + 2, -1), bJ(ny + 2), dJ(ny + 2, -1);
+  for (int i = 0; i <= nx + 1; i++) {
+    RealType x = offsetX + (i - RealType(0.5)) * dx;
+    bI[i]      = getCellIndex(x, boundaryPos_[0], boundaryPos_[1], originX_, bDX_, bNX_);
+    if (!noDisplacement_) {
+      dI[i] = getCellIndex(x, dBoundaryPos_[0], dBoundaryPos_[1], dOriginX_, dDX_, dNX_);
+    }
+  }
+  for (int j = 0; j <= ny + 1; j++) {
+    RealType y = offsetY + (j - RealType(0.5)) * dy;
+    bJ[j]      = getCellIndex(y, boundaryPos_[2], boundaryPos_[3], originY_, bDY_, bNY_);
+    if (!noDisplacement_) {
+      dJ[j] = getCellIndex(y, dBoundaryPos_[2], dBoundaryPos_[3], dOriginY_, dDY_, dNY_);
+    }
+  }
 
-  return d_[j][i];
+  Core::addWork(progress, ny + 2);
+
+  Core::parallelFor(0, ny + 2, [&](int jBegin, int jEnd) {
+    for (int j = jBegin; j < jEnd; j++) {
+      const RealType* bRow = bJ[j] >= 0 ? b_[bJ[j]] : nullptr;
+      const RealType* dRow = dJ[j] >= 0 ? d_[dJ[j]] : nullptr;
+
+      for (int i = 0; i <= nx + 1; i++) {
+        RealType bBefore = (bRow && bI[i] >= 0) ? clampBathymetry(bRow[bI[i]]) : RealType(0.0);
+        RealType displ   = (dRow && dI[i] >= 0) ? dRow[dI[i]] : RealType(0.0);
+
+        h[j][i]  = -std::fmin(bBefore, RealType(0.0));
+        hu[j][i] = RealType(0.0);
+        hv[j][i] = RealType(0.0);
+        b[j][i]  = bBefore + displ;
+      }
+      if (!Core::advance(progress)) {
+        return;
+      }
+    }
+  });
 }
 #endif
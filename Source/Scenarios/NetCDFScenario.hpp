@@ -10,12 +10,33 @@ namespace Scenarios {
 
   class NetCDFScenario: public Scenario {
   public:
-    NetCDFScenario(const std::string& bathymetryFile, const std::string& displacementFile, BoundaryType boundaryType);
+    /**
+     * Loads bathymetry and (optional) displacement from NetCDF files.
+     *
+     * If the grid size nx x ny of the simulation is given, the data is read with a stride so that
+     * it is not finer than the simulation grid, instead of reading the whole variables.
+     * Reading stops early if progress gets cancelled, the scenario is not loaded successfully then.
+     */
+    NetCDFScenario(const std::string& bathymetryFile, const std::string& displacementFile, BoundaryType boundaryType, int nx = 0, int ny = 0, Core::Progress* progress = nullptr);
     ~NetCDFScenario() override = default;
 
     RealType getBathymetryBeforeDisplacement(RealType x, RealType y) const override;
     RealType getDisplacement(RealType x, RealType y) const override;
 
+    void sampleGrid(
+      RealType           offsetX,
+      RealType           offsetY,
+      RealType           dx,
+      RealType           dy,
+      int                nx,
+      int                ny,
+      Float2D<RealType>& h,
+      Float2D<RealType>& hu,
+      Float2D<RealType>& hv,
+      Float2D<RealType>& b,
+      Core::Progress*    progress = nullptr
+    ) const override;
+
     BoundaryType getBoundaryType(BoundaryEdge) const override { return boundaryType_; }
     RealType     getBoundaryPos(BoundaryEdge edge) const override { return boundaryPos_[edge]; }
 
@@ -2,42 +2,32 @@
 
 #include <cassert>
 #include <cmath>
-#include <fstream>
+#include <cstdio>
 #include <iostream>
+#include <vector>
 
-Scenarios::RealisticScenario::RealisticScenario(RealisticScenarioType scenario, BoundaryType boundaryType):
-  boundaryType_(boundaryType) {
-  std::string bathymetryFile, displacementFile;
+#include "Core/Parallel.hpp"
+#include "Core/Trace.hpp"
 
-  switch (scenario) {
-  case RealisticScenarioType::Tohoku:
-    bathymetryFile   = "Assets/Data/tohoku_bath.bin";
-    displacementFile = "Assets/Data/tohoku_displ.bin";
-    break;
-  case RealisticScenarioType::TohokuZoomed:
-    bathymetryFile   = "Assets/Data/tohoku_bath_zoomed.bin";
-    displacementFile = "Assets/Data/tohoku_displ.bin";
-    break;
-  case RealisticScenarioType::Chile:
-    bathymetryFile   = "Assets/Data/chile_bath.bin";
-    displacementFile = "Assets/Data/chile_displ.bin";
-    break;
-  default:
-    assert(false);
-  }
+Scenarios::RealisticScenario::RealisticScenario(RealisticScenarioType scenario, BoundaryType boundaryType, int nx, int ny, ResampleMode resampleMode):
+  boundaryType_(boundaryType),
+  resampleMode_(resampleMode) {
+  getDataFiles(scenario, bathymetryFile_, displacementFile_);
 
   // Bathymetry file
   try {
 #ifndef NDEBUG
-    std::cout << "Reading bathymetry file " << bathymetryFile << std::endl;
+    std::cout << "Reading bathymetry file " << bathymetryFile_ << std::endl;
 #endif
-    FileHeader header;
-
-    if (!loadBinaryData(bathymetryFile, header, b_)) {
+    if (!bFile_.load(bathymetryFile_, nx, ny)) {
       success_ = false;
       return;
     }
 
+    const GridFile::FileHeader& header = bFile_.getHeader();
+    const GridFile::FileHeader& domain = bFile_.getDomain();
+    b_                                 = Float2D<const float>(header.nY, header.nX, bFile_.getData().getData());
+
     bNX_ = header.nX;
     bNY_ = header.nY;
     bDX_ = header.dx;
@@ -45,14 +35,15 @@ Scenarios::RealisticScenario::RealisticScenario(RealisticScenarioType scenario,
 
     assert(bNX_ >= 2 && bNY_ >= 2);
 
-    // Determine bathymetry domain boundaries
-    boundaryPos_[0] = header.originX - bDX_ / 2.0;
-    boundaryPos_[1] = boundaryPos_[0] + bDX_ * bNX_;
-    boundaryPos_[2] = header.originY - bDY_ / 2.0;
-    boundaryPos_[3] = boundaryPos_[2] + bDY_ * bNY_;
+    // Determine bathymetry domain boundaries from the full resolution, so they don't depend on the selected level
+    // (a coarse level may extend past them, its cells are clipped)
+    boundaryPos_[0] = domain.originX - domain.dx / 2.0;
+    boundaryPos_[1] = boundaryPos_[0] + domain.dx * domain.nX;
+    boundaryPos_[2] = domain.originY - domain.dy / 2.0;
+    boundaryPos_[3] = boundaryPos_[2] + domain.dy * domain.nY;
 
-    originX_ = boundaryPos_[0];
-    originY_ = boundaryPos_[2];
+    originX_ = header.originX - bDX_ / 2.0; // All levels start at the same lower corner
+    originY_ = header.originY - bDY_ / 2.0;
 
   } catch (const std::exception& e) {
     // std::cerr << "Error reading bathymetry file: " << e.what() << std::endl;
@@ -63,15 +54,17 @@ Scenarios::RealisticScenario::RealisticScenario(RealisticScenarioType scenario,
   // Displacement file
   try {
 #ifndef NDEBUG
-    std::cout << "Reading displacement file " << displacementFile << std::endl;
+    std::cout << "Reading displacement file " << displacementFile_ << std::endl;
 #endif
-    FileHeader header;
-
-    if (!loadBinaryData(displacementFile, header, d_)) {
+    if (!dFile_.load(displacementFile_)) {
       success_ = false;
       return;
     }
 
+    const GridFile::FileHeader& header = dFile_.getHeader();
+    const GridFile::FileHeader& domain = dFile_.getDomain();
+    d_                                 = Float2D<const float>(header.nY, header.nX, dFile_.getData().getData());
+
     dNX_ = header.nX;
     dNY_ = header.nY;
     dDX_ = header.dx;
@@ -79,11 +72,11 @@ Scenarios::RealisticScenario::RealisticScenario(RealisticScenarioType scenario,
 
     assert(dNX_ >= 2 && dNY_ >= 2);
 
-    // Determine displacement domain boundaries
-    dBoundaryPos_[0] = header.originX - dDX_ / 2.0;
-    dBoundaryPos_[1] = dBoundaryPos_[0] + dDX_ * dNX_;
-    dBoundaryPos_[2] = header.originY - dDY_ / 2.0;
-    dBoundaryPos_[3] = dBoundaryPos_[2] + dDY_ * dNY_;
+    // Determine displacement domain boundaries (of the full resolution as for the bathymetry)
+    dBoundaryPos_[0] = domain.originX - domain.dx / 2.0;
+    dBoundaryPos_[1] = dBoundaryPos_[0] + domain.dx * domain.nX;
+    dBoundaryPos_[2] = domain.originY - domain.dy / 2.0;
+    dBoundaryPos_[3] = dBoundaryPos_[2] + domain.dy * domain.nY;
 
     // Displacement should be located within the domain of the bathymetry
     assert(dBoundaryPos_[0] >= boundaryPos_[0]);
@@ -91,8 +84,8 @@ Scenarios::RealisticScenario::RealisticScenario(RealisticScenarioType scenario,
     assert(dBoundaryPos_[2] >= boundaryPos_[2]);
     assert(dBoundaryPos_[3] <= boundaryPos_[3]);
 
-    dOriginX_ = dBoundaryPos_[0];
-    dOriginY_ = dBoundaryPos_[2];
+    dOriginX_ = header.originX - dDX_ / 2.0;
+    dOriginY_ = header.originY - dDY_ / 2.0;
 
   } catch (const std::exception& e) {
     // std::cerr << "Error reading displacement file: " << e.what() << std::endl;
@@ -101,67 +94,145 @@ Scenarios::RealisticScenario::RealisticScenario(RealisticScenarioType scenario,
   }
 }
 
-bool Scenarios::RealisticScenario::loadBinaryData(const std::string& filename, FileHeader& header, Float2D<float>& data) {
+void Scenarios::RealisticScenario::getDataFiles(RealisticScenarioType scenario, std::string& bathymetryFile, std::string& displacementFile) {
+  switch (scenario) {
+  case RealisticScenarioType::Tohoku:
+    bathymetryFile   = "Assets/Data/tohoku_bath.bin";
+    displacementFile = "Assets/Data/tohoku_displ.bin";
+    break;
+  case RealisticScenarioType::TohokuZoomed:
+    bathymetryFile   = "Assets/Data/tohoku_bath_zoomed.bin";
+    displacementFile = "Assets/Data/tohoku_displ.bin";
+    break;
+  case RealisticScenarioType::Chile:
+    bathymetryFile   = "Assets/Data/chile_bath.bin";
+    displacementFile = "Assets/Data/chile_displ.bin";
+    break;
+  default:
+    assert(false);
+  }
+}
 
-  std::ifstream file(filename, std::ios::binary);
-  if (!file)
-    return false;
+RealType Scenarios::RealisticScenario::getBathymetryBeforeDisplacement(RealType x, RealType y) const {
+  if (resampleMode_ != ResampleMode::Nearest) {
+    float value;
+    if (!sampleBilinear(b_, {boundaryPos_[0], bDX_, bNX_, boundaryPos_[1]}, {boundaryPos_[2], bDY_, bNY_, boundaryPos_[3]}, x, y, value)) {
+      return RealType(0.0);
+    }
+    return clampBathymetry(value);
+  }
 
-  // Read header
-  file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
-  if (!file)
-    return false;
+  int i = getCellIndex(x, boundaryPos_[0], boundaryPos_[1], originX_, bDX_, bNX_);
+  int j = getCellIndex(y, boundaryPos_[2], boundaryPos_[3], originY_, bDY_, bNY_);
 
-  // Allocate and read data
-  data = Float2D<float>(header.nY, header.nX);
-  file.read(reinterpret_cast<char*>(data.getData()), header.nX * header.nY * sizeof(float));
+  if (i < 0 || j < 0) {
+    return RealType(0.0); // Will be later replaced by a boundary condition
+  }
 
-  return file.good();
+  return clampBathymetry(b_[j][i]);
 }
 
-RealType Scenarios::RealisticScenario::getBathymetryBeforeDisplacement(RealType x, RealType y) const {
-  if (x < boundaryPos_[0] || x > boundaryPos_[1] || y < boundaryPos_[2] || y > boundaryPos_[3]) {
-    return RealType(0.0); // Will be later replaced by a boundary condition
+RealType Scenarios::RealisticScenario::getDisplacement(RealType x, RealType y) const {
+  if (resampleMode_ != ResampleMode::Nearest) {
+    float value;
+    if (!sampleBilinear(d_, {dBoundaryPos_[0], dDX_, dNX_, dBoundaryPos_[1]}, {dBoundaryPos_[2], dDY_, dNY_, dBoundaryPos_[3]}, x, y, value)) {
+      return RealType(0.0);
+    }
+    return value;
   }
 
-  // Determine indices
-  int i = std::round((x - originX_) / bDX_ - 0.5);
-  int j = std::round((y - originY_) / bDY_ - 0.5);
+  int i = getCellIndex(x, dBoundaryPos_[0], dBoundaryPos_[1], dOriginX_, dDX_, dNX_);
+  int j = getCellIndex(y, dBoundaryPos_[2], dBoundaryPos_[3], dOriginY_, dDY_, dNY_);
 
-  assert(i >= 0 && i < bNX_);
-  assert(j >= 0 && j < bNY_);
+  if (i < 0 || j < 0) {
+    return RealType(0.0); // No displacement
+  }
 
-  RealType b = b_[j][i];
+  return d_[j][i];
+}
 
-  // Clamp the bathymetry to a minimum of 20m
-  if (std::abs(b) < 20.0) {
-    b = RealType(20.0 * std::copysign(1.0, b));
+void Scenarios::RealisticScenario::sampleGrid(
+  RealType           offsetX,
+  RealType           offsetY,
+  RealType           dx,
+  RealType           dy,
+  int                nx,
+  int                ny,
+  Float2D<RealType>& h,
+  Float2D<RealType>& hu,
+  Float2D<RealType>& hv,
+  Float2D<RealType>& b,
+  Core::Progress*    progress
+) const {
+  SWE_TRACE_ZONE("Sample Grid");
+
+  // The grid is axis-aligned, so the resampling taps only depend on the column or the row respectively
+  ResampleAxis bX = buildResampleAxis(resampleMode_, {boundaryPos_[0], bDX_, bNX_, boundaryPos_[1]}, offsetX, dx, nx + 2);
+  ResampleAxis bY = buildResampleAxis(resampleMode_, {boundaryPos_[2], bDY_, bNY_, boundaryPos_[3]}, offsetY, dy, ny + 2);
+  ResampleAxis dX = buildResampleAxis(resampleMode_, {dBoundaryPos_[0], dDX_, dNX_, dBoundaryPos_[1]}, offsetX, dx, nx + 2);
+  ResampleAxis dY = buildResampleAxis(resampleMode_, {dBoundaryPos_[2], dDY_, dNY_, dBoundaryPos_[3]}, offsetY, dy, ny + 2);
+
+  char gridKey[160];
+  std::snprintf(gridKey, sizeof(gridKey), "%d|%.17g|%.17g|%.17g|%.17g|%d|%d", (int)resampleMode_, (double)offsetX, (double)offsetY, (double)dx, (double)dy, nx, ny);
+
+  // Both resampled grids and the final pass, one unit per row each
+  Core::addWork(progress, 3 * (ny + 2));
+
+  Float2D<float> bBefore(ny + 2, nx + 2);
+  Float2D<float> displ(ny + 2, nx + 2);
+  if (!resampleData(bathymetryFile_, bFile_, b_, bX, bY, gridKey, bBefore, progress) || !resampleData(displacementFile_, dFile_, d_, dX, dY, gridKey, displ, progress)) {
+    return;
   }
 
-  return b;
+  Core::parallelFor(0, ny + 2, [&](int jBegin, int jEnd) {
+    for (int j = jBegin; j < jEnd; j++) {
+      for (int i = 0; i <= nx + 1; i++) {
+        // Cells outside of the bathymetry domain are set by the boundary condition later
+        bool     inside = bX.count[i] > 0 && bY.count[j] > 0;
+        RealType bCell  = inside ? clampBathymetry(bBefore[j][i]) : RealType(0.0);
+
+        h[j][i]  = -std::fmin(bCell, RealType(0.0));
+        hu[j][i] = RealType(0.0);
+        hv[j][i] = RealType(0.0);
+        b[j][i]  = bCell + RealType(displ[j][i]);
+      }
+      if (!Core::advance(progress)) {
+        return;
+      }
+    }
+  });
 }
 
-RealType Scenarios::RealisticScenario::getDisplacement(RealType x, RealType y) const {
-  if (x < dBoundaryPos_[0] || x > dBoundaryPos_[1] || y < dBoundaryPos_[2] || y > dBoundaryPos_[3]) {
-    return RealType(0.0); // No displacement
+bool Scenarios::RealisticScenario::resampleData(
+  const std::string&          fileName,
+  const GridFile&             file,
+  const Float2D<const float>& data,
+  const ResampleAxis&         x,
+  const ResampleAxis&         y,
+  const std::string&          gridKey,
+  Float2D<float>&             target,
+  Core::Progress*             progress
+) const {
+  // Nearest-neighbour lookups are cheaper than reading the cache
+  if (resampleMode_ == ResampleMode::Nearest) {
+    return resample(data, x, y, target, progress);
   }
 
-  // Determine indices
-  int i = std::round((x - dOriginX_) / dDX_ - 0.5);
-  int j = std::round((y - dOriginY_) / dDY_ - 0.5);
+  // Identify the source by the mapping the data was read from, so that regenerated data files invalidate the cache
+  const Core::MappedFile& mapping = file.getFile();
 
-  // Handle edge cases
-  if (x == dBoundaryPos_[0])
-    i = 0;
-  if (x == dBoundaryPos_[1])
-    i = dNX_ - 1;
-  if (y == dBoundaryPos_[2])
-    j = 0;
-  if (y == dBoundaryPos_[3])
-    j = dNY_ - 1;
+  char sourceKey[80];
+  std::snprintf(sourceKey, sizeof(sourceKey), "|%llu|%lld|%d|%d|", (unsigned long long)mapping.getSize(), (long long)mapping.getWriteTime(), data.getRows(), data.getCols());
 
-  assert(i >= 0 && i < dNX_);
-  assert(j >= 0 && j < dNY_);
+  std::string key = fileName + sourceKey + gridKey;
+  if (loadResampleCache(key, target)) {
+    return Core::advance(progress, y.count.size());
+  }
 
-  return d_[j][i];
+  // A cancelled resampling is incomplete and must not be cached
+  if (!resample(data, x, y, target, progress)) {
+    return false;
+  }
+  storeResampleCache(key, target);
+  return true;
 }
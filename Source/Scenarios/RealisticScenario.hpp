@@ -1,8 +1,9 @@
 #pragma once
 
-#include <cstdint>
 #include <string>
 
+#include "GridFile.hpp"
+#include "Resampler.hpp"
 #include "Scenario.hpp"
 #include "Types/Float2D.hpp"
 
@@ -16,42 +17,71 @@ namespace Scenarios {
 
   class RealisticScenario: public Scenario {
   public:
-    RealisticScenario(RealisticScenarioType scenario, BoundaryType boundaryType);
+    /**
+     * @param nx, ny Size of the grid the scenario will be sampled on. Selects the resolution level of tiled
+     * data files, 0 loads the full resolution.
+     * @param resampleMode Filter used to sample the data onto the grid. Point queries use bilinear
+     * interpolation for the area mode, as a point has no extent to average over.
+     */
+    RealisticScenario(RealisticScenarioType scenario, BoundaryType boundaryType, int nx = 0, int ny = 0, ResampleMode resampleMode = ResampleMode::Nearest);
     ~RealisticScenario() override = default;
 
+    /// Paths of the data files of a scenario, relative to the working directory (the page in the web build)
+    static void getDataFiles(RealisticScenarioType scenario, std::string& bathymetryFile, std::string& displacementFile);
+
     RealType getBathymetryBeforeDisplacement(RealType x, RealType y) const override;
     RealType getDisplacement(RealType x, RealType y) const override;
 
+    void sampleGrid(
+      RealType           offsetX,
+      RealType           offsetY,
+      RealType           dx,
+      RealType           dy,
+      int                nx,
+      int                ny,
+      Float2D<RealType>& h,
+      Float2D<RealType>& hu,
+      Float2D<RealType>& hv,
+      Float2D<RealType>& b,
+      Core::Progress*    progress = nullptr
+    ) const override;
+
     BoundaryType getBoundaryType(BoundaryEdge) const override { return boundaryType_; }
     RealType     getBoundaryPos(BoundaryEdge edge) const override { return boundaryPos_[edge]; }
 
     bool loadSuccess() const override { return success_; }
 
   private:
-    struct FileHeader {
-      uint32_t nX;
-      uint32_t nY;
-      double   originX;
-      double   originY;
-      double   dx;
-      double   dy;
-    };
-
-    bool loadBinaryData(const std::string& filename, FileHeader& header, Float2D<float>& data);
+    /// Resamples data onto the cell centers of the grid, using the on-disk cache for the smooth filters. Returns false if cancelled.
+    bool resampleData(
+      const std::string&          fileName,
+      const GridFile&             file,
+      const Float2D<const float>& data,
+      const ResampleAxis&         x,
+      const ResampleAxis&         y,
+      const std::string&          gridKey,
+      Float2D<float>&             target,
+      Core::Progress*             progress
+    ) const;
 
     BoundaryType boundaryType_;
+    ResampleMode resampleMode_;
+
+    std::string          bathymetryFile_;
+    GridFile             bFile_;
+    Float2D<const float> b_;
+    int                  bNX_, bNY_;
+    double               boundaryPos_[4];
+    RealType             originX_, originY_;
+    RealType             bDX_, bDY_;
 
-    Float2D<float> b_;
-    int            bNX_, bNY_;
-    double         boundaryPos_[4];
-    RealType       originX_, originY_;
-    RealType       bDX_, bDY_;
-
-    Float2D<float> d_;
-    int            dNX_, dNY_;
-    double         dBoundaryPos_[4];
-    RealType       dOriginX_, dOriginY_;
-    RealType       dDX_, dDY_;
+    std::string          displacementFile_;
+    GridFile             dFile_;
+    Float2D<const float> d_;
+    int                  dNX_, dNY_;
+    double               dBoundaryPos_[4];
+    RealType             dOriginX_, dOriginY_;
+    RealType             dDX_, dDY_;
 
     bool success_ = true;
   };
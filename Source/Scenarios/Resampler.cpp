@@ -0,0 +1,248 @@
+#include "Resampler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+
+#include "Core/MappedFile.hpp"
+#include "Core/Trace.hpp"
+#include "Core/Parallel.hpp"
+
+namespace Scenarios {
+
+  static bool getBilinearTaps(double pos, const ResampleSource& source, int& i0, int& i1, float& w1) {
+    if (pos < source.lower || pos > source.upper) {
+      return false;
+    }
+
+    // Interpolate between the two nearest cell centers, constant towards the domain boundary
+    double p = (pos - source.lower) / source.cellSize - 0.5;
+    double f = std::floor(p);
+    i0       = std::clamp((int)f, 0, source.n - 1);
+    i1       = std::clamp((int)f + 1, 0, source.n - 1);
+    w1       = float(p - f);
+    return true;
+  }
+
+  bool sampleBilinear(const Float2D<const float>& data, const ResampleSource& x, const ResampleSource& y, double posX, double posY, float& value) {
+    int   i0, i1, j0, j1;
+    float wi, wj;
+    if (!getBilinearTaps(posX, x, i0, i1, wi) || !getBilinearTaps(posY, y, j0, j1, wj)) {
+      return false;
+    }
+
+    float row0 = (1.0f - wi) * data[j0][i0] + wi * data[j0][i1];
+    float row1 = (1.0f - wi) * data[j1][i0] + wi * data[j1][i1];
+    value      = (1.0f - wj) * row0 + wj * row1;
+    return true;
+  }
+
+  ResampleAxis buildResampleAxis(ResampleMode mode, const ResampleSource& source, double offset, double spacing, int n) {
+    ResampleAxis axis;
+    axis.first.resize(n);
+    axis.count.resize(n);
+
+    double upper = source.upper;
+
+    for (int t = 0; t < n; t++) {
+      double center = offset + (t - 0.5) * spacing;
+
+      axis.first[t] = (int)axis.index.size();
+      axis.count[t] = 0;
+
+      if (center < source.lower || center > upper) {
+        continue;
+      }
+
+      switch (mode) {
+      case ResampleMode::Nearest: {
+        int s = (int)std::round((center - source.lower) / source.cellSize - 0.5);
+        axis.index.push_back(std::clamp(s, 0, source.n - 1));
+        axis.weight.push_back(1.0f);
+        break;
+      }
+      case ResampleMode::Bilinear: {
+        int   i0, i1;
+        float w1;
+        getBilinearTaps(center, source, i0, i1, w1);
+        axis.index.push_back(i0);
+        axis.weight.push_back(1.0f - w1);
+        if (i1 != i0 && w1 > 0.0f) {
+          axis.index.push_back(i1);
+          axis.weight.push_back(w1);
+        }
+        break;
+      }
+      case ResampleMode::Area: {
+        // Overlap of the target cell with the source cells (clipped to the source domain)
+        double lower  = std::max(center - spacing * 0.5, source.lower);
+        double higher = std::min(center + spacing * 0.5, upper);
+        int    sBegin = std::clamp((int)std::floor((lower - source.lower) / source.cellSize), 0, source.n - 1);
+        int    sEnd   = std::clamp((int)std::ceil((higher - source.lower) / source.cellSize), sBegin + 1, source.n);
+
+        double total = 0.0;
+        for (int s = sBegin; s < sEnd; s++) {
+          double cellLower = source.lower + s * source.cellSize;
+          double overlap   = std::min(higher, cellLower + source.cellSize) - std::max(lower, cellLower);
+          if (overlap > 0.0) {
+            axis.index.push_back(s);
+            axis.weight.push_back((float)overlap);
+            total += overlap;
+          }
+        }
+
+        if (total <= 0.0) { // Degenerate target cell, fall back to the containing cell
+          axis.index.push_back(sBegin);
+          axis.weight.push_back(1.0f);
+          total = 1.0;
+        }
+        for (size_t k = axis.first[t]; k < axis.weight.size(); k++) {
+          axis.weight[k] = float(axis.weight[k] / total);
+        }
+        break;
+      }
+      }
+
+      axis.count[t] = (int)axis.index.size() - axis.first[t];
+    }
+
+    return axis;
+  }
+
+  bool resample(const Float2D<const float>& source, const ResampleAxis& x, const ResampleAxis& y, Float2D<float>& target, Core::Progress* progress) {
+    SWE_TRACE_ZONE("Resample");
+
+    int nx = (int)x.count.size();
+    int ny = (int)y.count.size();
+
+    Core::parallelFor(0, ny, [&](int jBegin, int jEnd) {
+      std::vector<float> row(nx);
+
+      for (int j = jBegin; j < jEnd; j++) {
+        std::fill(row.begin(), row.end(), 0.0f);
+
+        // Accumulate the horizontally resampled source rows of all vertical taps
+        for (int tj = y.first[j]; tj < y.first[j] + y.count[j]; tj++) {
+          const float* sourceRow = source[y.index[tj]];
+          float        wy        = y.weight[tj];
+
+          for (int i = 0; i < nx; i++) {
+            float value = 0.0f;
+            for (int ti = x.first[i]; ti < x.first[i] + x.count[i]; ti++) {
+              value += x.weight[ti] * sourceRow[x.index[ti]];
+            }
+            row[i] += wy * value;
+          }
+        }
+
+        // Cells outside of the source domain in x have no taps and stay 0
+        std::copy(row.begin(), row.end(), target[j]);
+
+        if (!Core::advance(progress)) {
+          return;
+        }
+      }
+    });
+
+    return !progress || !progress->isCancelled();
+  }
+
+  struct ResampleCacheHeader {
+    char     magic[4]; // "SWER"
+    uint32_t keySize;
+    uint32_t nx;
+    uint32_t ny;
+  };
+
+  static std::filesystem::path getCachePath(const std::string& key) {
+    std::error_code       error;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(error);
+    if (error) {
+      return {};
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016zx.bin", std::hash<std::string>{}(key));
+    return directory / "swe-resample-cache" / name;
+  }
+
+  bool loadResampleCache(const std::string& key, Float2D<float>& data) {
+    SWE_TRACE_ZONE("Load Resample Cache");
+
+    std::filesystem::path path = getCachePath(key);
+    if (path.empty()) {
+      return false;
+    }
+
+    auto file = Core::MappedFile::open(path.string());
+    if (!file || file->getSize() < sizeof(ResampleCacheHeader)) {
+      return false;
+    }
+
+    ResampleCacheHeader header;
+    std::memcpy(&header, file->getData(), sizeof(ResampleCacheHeader));
+
+    size_t dataSize = size_t(header.nx) * header.ny * sizeof(float);
+    if (std::memcmp(header.magic, "SWER", 4) != 0 || (int)header.nx != data.getRows() || (int)header.ny != data.getCols()) {
+      return false;
+    }
+    if (file->getSize() != sizeof(ResampleCacheHeader) + header.keySize + dataSize) {
+      return false;
+    }
+    if (header.keySize != key.size() || std::memcmp(file->getData() + sizeof(ResampleCacheHeader), key.data(), key.size()) != 0) {
+      return false; // Hash collision
+    }
+
+    std::memcpy(data.getData(), file->getData() + sizeof(ResampleCacheHeader) + header.keySize, dataSize);
+    return true;
+  }
+
+  void storeResampleCache(const std::string& key, const Float2D<float>& data) {
+    SWE_TRACE_ZONE("Store Resample Cache");
+
+    std::filesystem::path path = getCachePath(key);
+    if (path.empty()) {
+      return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error) {
+      return;
+    }
+
+    ResampleCacheHeader header = {{'S', 'W', 'E', 'R'}, (uint32_t)key.size(), (uint32_t)data.getRows(), (uint32_t)data.getCols()};
+
+    // Write to a temporary file first, so that concurrent readers never see a partial entry. Its name is unique to
+    // this write (random per process, counted within it), so concurrent writers of the same key never share one.
+    static const uint32_t        s_processTag = std::random_device()();
+    static std::atomic<uint32_t> s_writeCount = 0;
+    char                         suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%08x-%u.tmp", s_processTag, s_writeCount.fetch_add(1));
+    std::filesystem::path tempPath = path;
+    tempPath += suffix;
+    {
+      std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+      stream.write(reinterpret_cast<const char*>(&header), sizeof(ResampleCacheHeader));
+      stream.write(key.data(), key.size());
+      stream.write(reinterpret_cast<const char*>(data.getData()), std::streamsize(data.getRows()) * data.getCols() * sizeof(float));
+      if (!stream) {
+        stream.close();
+        std::filesystem::remove(tempPath, error);
+        return;
+      }
+    }
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+      std::filesystem::remove(tempPath, error);
+    }
+  }
+
+} // namespace Scenarios
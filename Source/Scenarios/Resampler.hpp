@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Core/Progress.hpp"
+#include "Types/Float2D.hpp"
+
+namespace Scenarios {
+
+  enum class ResampleMode {
+    Nearest,
+    Bilinear,
+    Area, // Average of all source cells covered by a target cell, weighted by their overlap
+  };
+
+  /**
+   * Source cells along one axis: cell s covers [lower + s * cellSize, lower + (s + 1) * cellSize].
+   *
+   * The data ends at upper, which may lie inside the last cell (coarse levels of a GridFile are padded past the domain).
+   */
+  struct ResampleSource {
+    double lower;
+    double cellSize;
+    int    n;
+    double upper;
+  };
+
+  /**
+   * Precomputed taps of all target cells along one axis.
+   *
+   * Resampling is separable, so a target cell (i, j) is the weighted sum over the taps of column i
+   * and row j. Cells outside of the source domain have no taps and are set to 0.
+   */
+  struct ResampleAxis {
+    std::vector<int>   first;  // First tap of each target cell
+    std::vector<int>   count;  // Number of taps of each target cell
+    std::vector<int>   index;  // Source cell of each tap
+    std::vector<float> weight; // Weight of each tap (the weights of a target cell sum up to 1)
+  };
+
+  /**
+   * Builds the taps for n target cells of size spacing, the center of cell t being offset + (t - 0.5) * spacing.
+   * This matches the cell centers (including the ghost layer) used by Scenario::sampleGrid.
+   */
+  ResampleAxis buildResampleAxis(ResampleMode mode, const ResampleSource& source, double offset, double spacing, int n);
+
+  /**
+   * Bilinear interpolation of data at a single position.
+   *
+   * @return false if the position is outside of the source domain.
+   */
+  bool sampleBilinear(const Float2D<const float>& data, const ResampleSource& x, const ResampleSource& y, double posX, double posY, float& value);
+
+  /**
+   * Resamples source onto target (target rows x columns given by y and x), one thread per chunk of target rows.
+   *
+   * Advances progress by one unit per target row (the caller adds the work).
+   *
+   * @return false if progress was cancelled, target is only partially resampled then.
+   */
+  bool resample(const Float2D<const float>& source, const ResampleAxis& x, const ResampleAxis& y, Float2D<float>& target, Core::Progress* progress = nullptr);
+
+  /**
+   * On-disk cache of resampled grids, so that a scenario opened again at the same resolution is a single read.
+   *
+   * Entries are stored in the temporary directory of the system. The key has to describe everything the
+   * result depends on (source file, domain, resolution, mode); it is stored in the entry to detect hash collisions.
+   */
+  bool loadResampleCache(const std::string& key, Float2D<float>& data);
+  void storeResampleCache(const std::string& key, const Float2D<float>& data);
+
+} // namespace Scenarios
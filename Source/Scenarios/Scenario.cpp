@@ -22,8 +22,12 @@
 
 #include "Scenario.hpp"
 
+#include <algorithm>
 #include <cmath>
 
+#include "Core/Parallel.hpp"
+#include "Core/Trace.hpp"
+
 RealType Scenarios::Scenario::getWaterHeight([[maybe_unused]] RealType x, [[maybe_unused]] RealType y) const {
   return -std::fmin(getBathymetryBeforeDisplacement(x, y), RealType(0.0));
 }
@@ -51,3 +55,60 @@ RealType Scenarios::Scenario::getBoundaryPos(BoundaryEdge edge) const {
 }
 
 bool Scenarios::Scenario::loadSuccess() const { return true; }
+
+void Scenarios::Scenario::sampleGrid(
+  RealType           offsetX,
+  RealType           offsetY,
+  RealType           dx,
+  RealType           dy,
+  int                nx,
+  int                ny,
+  Float2D<RealType>& h,
+  Float2D<RealType>& hu,
+  Float2D<RealType>& hv,
+  Float2D<RealType>& b,
+  Core::Progress*    progress
+) const {
+  SWE_TRACE_ZONE("Sample Grid");
+
+  Core::addWork(progress, ny + 2);
+
+  // Scenarios that are not thread-safe are sampled in a single chunk, which runs on the calling thread
+  int minChunk = isThreadSafe() ? 1 : ny + 2;
+
+  Core::parallelFor(
+    0,
+    ny + 2,
+    [&](int jBegin, int jEnd) {
+      for (int j = jBegin; j < jEnd; j++) {
+        RealType y = offsetY + (j - RealType(0.5)) * dy;
+        for (int i = 0; i <= nx + 1; i++) {
+          RealType x = offsetX + (i - RealType(0.5)) * dx;
+          h[j][i]    = getWaterHeight(x, y);
+          hu[j][i]   = getMomentumU(x, y);
+          hv[j][i]   = getMomentumV(x, y);
+          b[j][i]    = getBathymetry(x, y);
+        }
+        if (!Core::advance(progress)) {
+          return;
+        }
+      }
+    },
+    minChunk
+  );
+}
+
+int Scenarios::Scenario::getCellIndex(RealType pos, double lower, double upper, RealType origin, RealType cellSize, int n) {
+  if (pos < lower || pos > upper) {
+    return -1;
+  }
+  int i = std::round((pos - origin) / cellSize - 0.5);
+  return std::clamp(i, 0, n - 1); // Positions exactly on the upper boundary belong to the last cell
+}
+
+RealType Scenarios::Scenario::clampBathymetry(RealType b) {
+  if (std::abs(b) < 20.0) {
+    b = RealType(20.0 * std::copysign(1.0, b));
+  }
+  return b;
+}
@@ -22,8 +22,10 @@
 
 #pragma once
 
+#include "Core/Progress.hpp"
 #include "Types/BoundaryEdge.hpp"
 #include "Types/BoundaryType.hpp"
+#include "Types/Float2D.hpp"
 #include "Types/RealType.hpp"
 
 namespace Scenarios {
@@ -36,6 +38,10 @@ namespace Scenarios {
    * basic scenario (all functions are constant); however, the idea is
    * to provide derived classes that implement the Scenarios::Scenario interface
    * for more interesting scenarios.
+   *
+   * The getters are called from several threads at once (see sampleGrid), so overrides must not modify
+   * shared state without synchronisation, e.g. caches filled lazily. Scenarios that can't guarantee this
+   * return false from isThreadSafe.
    */
   class Scenario {
   public:
@@ -53,6 +59,43 @@ namespace Scenarios {
     virtual RealType     getBoundaryPos(BoundaryEdge edge) const;
 
     virtual bool loadSuccess() const;
+
+    /// Whether the getters may be called from several threads at once, the default sampleGrid runs serially otherwise
+    virtual bool isThreadSafe() const { return true; }
+
+    /**
+     * Samples water height, momentum and bathymetry at the cell centers of a regular grid in one pass.
+     *
+     * The arrays are indexed as a[j][i] with i in [0, nx + 1] and j in [0, ny + 1], where cell (i, j) is
+     * located at (offsetX + (i - 0.5) * dx, offsetY + (j - 0.5) * dy), i.e. including the ghost layer of
+     * a Blocks::Block. The default implementation evaluates the point-wise getters row-parallel (serially
+     * if isThreadSafe returns false); scenarios backed by gridded data override it to avoid the per-cell virtual calls.
+     *
+     * Progress is reported per row, the arrays are left partially sampled if it gets cancelled.
+     */
+    virtual void sampleGrid(
+      RealType           offsetX,
+      RealType           offsetY,
+      RealType           dx,
+      RealType           dy,
+      int                nx,
+      int                ny,
+      Float2D<RealType>& h,
+      Float2D<RealType>& hu,
+      Float2D<RealType>& hv,
+      Float2D<RealType>& b,
+      Core::Progress*    progress = nullptr
+    ) const;
+
+  protected:
+    /**
+     * Returns the index of the data cell of a grid with n cells between lower and upper that contains pos,
+     * or -1 if pos lies outside of the grid.
+     */
+    static int getCellIndex(RealType pos, double lower, double upper, RealType origin, RealType cellSize, int n);
+
+    /// Clamps the bathymetry to a minimum depth/height of 20m
+    static RealType clampBathymetry(RealType b);
   };
 
 } // namespace Scenarios
@@ -8,9 +8,12 @@
  */
 #include "Solvers/Fwave.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
+#include "Types/CompactFloat.hpp"
+
 #define EXIT_IF_NOT(condition) \
   if (!(condition)) { \
     Error = true; \
@@ -188,4 +191,135 @@ namespace Solvers {
     }
   }
 
+  // Row kernel on separate arrays, with a variant per instruction set level
+  template <class Row>
+  SWE_FORCE_INLINE static RealType computeNetUpdatesRowSoA(
+    Fwave&               solver,
+    int                  n,
+    Row                  left,
+    Row                  right,
+    RealType* __restrict o_hUpdateLeft,
+    RealType* __restrict o_hUpdateRight,
+    RealType* __restrict o_huUpdateLeft,
+    RealType* __restrict o_huUpdateRight,
+    RealType* __restrict o_waveSpeeds
+  ) {
+    return solver.computeNetUpdatesRow(n, left, right, o_hUpdateLeft, o_hUpdateRight, o_huUpdateLeft, o_huUpdateRight, o_waveSpeeds);
+  }
+
+  SWE_ISA_VARIANTS(RealType, computeNetUpdatesRowSoA)
+
+  RealType Fwave::computeNetUpdatesRow(
+    int                       n,
+    const RealType* __restrict hLeft,
+    const RealType* __restrict hRight,
+    const RealType* __restrict huLeft,
+    const RealType* __restrict huRight,
+    const RealType* __restrict bLeft,
+    const RealType* __restrict bRight,
+    RealType* __restrict       o_hUpdateLeft,
+    RealType* __restrict       o_hUpdateRight,
+    RealType* __restrict       o_huUpdateLeft,
+    RealType* __restrict       o_huUpdateRight,
+    RealType* __restrict       o_waveSpeeds
+  ) {
+
+    return SWE_ISA_CALL(
+      computeNetUpdatesRowSoA,
+      *this,
+      n,
+      SoALayout::Row{hLeft, huLeft, bLeft},
+      SoALayout::Row{hRight, huRight, bRight},
+      o_hUpdateLeft,
+      o_hUpdateRight,
+      o_huUpdateLeft,
+      o_huUpdateRight,
+      o_waveSpeeds
+    );
+  }
+
+
+  // Cell terms of computeNetUpdatesRow, with a variant per instruction set level
+  SWE_FORCE_INLINE static void computeCellTermsRow(
+    int                        n,
+    const RealType* __restrict h,
+    const RealType* __restrict hu,
+    RealType* __restrict       o_sqrtH,
+    RealType* __restrict       o_celerity,
+    RealType* __restrict       o_velocity
+  ) {
+
+    const RealType g = 9.81; // Gravitation constant
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+    for (int i = 0; i < n; i++) {
+      o_sqrtH[i]    = std::sqrt(h[i]);
+      o_celerity[i] = std::sqrt(g * h[i]);
+      o_velocity[i] = hu[i] / h[i];
+    }
+  }
+
+  SWE_ISA_VARIANTS(void, computeCellTermsRow)
+
+  void Fwave::computeCellTerms(
+    int                        n,
+    const RealType* __restrict h,
+    const RealType* __restrict hu,
+    RealType* __restrict       o_sqrtH,
+    RealType* __restrict       o_celerity,
+    RealType* __restrict       o_velocity
+  ) {
+
+    SWE_ISA_CALL(computeCellTermsRow, n, h, hu, o_sqrtH, o_celerity, o_velocity);
+  }
+
+  template <class Row>
+  RealType Fwave::computeNetUpdatesRow(
+    int                  n,
+    const Row&           left,
+    const Row&           right,
+    const CellTerms&     termsLeft,
+    const CellTerms&     termsRight,
+    RealType* __restrict o_hUpdateLeft,
+    RealType* __restrict o_hUpdateRight,
+    RealType* __restrict o_huUpdateLeft,
+    RealType* __restrict o_huUpdateRight,
+    RealType* __restrict o_waveSpeeds
+  ) {
+
+    return SWE_ISA_CALL(
+      computeNetUpdatesRowSoA,
+      *this,
+      n,
+      CellTermsRow<Row>{left, termsLeft},
+      CellTermsRow<Row>{right, termsRight},
+      o_hUpdateLeft,
+      o_hUpdateRight,
+      o_huUpdateLeft,
+      o_huUpdateRight,
+      o_waveSpeeds
+    );
+  }
+
+  template RealType Fwave::computeNetUpdatesRow<SoALayout::Row>(
+    int, const SoALayout::Row&, const SoALayout::Row&, const CellTerms&, const CellTerms&, RealType*, RealType*, RealType*, RealType*, RealType*
+  );
+  template RealType Fwave::computeNetUpdatesRow<CompactBathymetryRow<HalfFormat>>(
+    int, const CompactBathymetryRow<HalfFormat>&, const CompactBathymetryRow<HalfFormat>&, const CellTerms&, const CellTerms&, RealType*, RealType*, RealType*, RealType*, RealType*
+  );
+  template RealType Fwave::computeNetUpdatesRow<CompactBathymetryRow<BFloat16Format>>(
+    int,
+    const CompactBathymetryRow<BFloat16Format>&,
+    const CompactBathymetryRow<BFloat16Format>&,
+    const CellTerms&,
+    const CellTerms&,
+    RealType*,
+    RealType*,
+    RealType*,
+    RealType*,
+    RealType*
+  );
+
 } // namespace Solvers
@@ -8,6 +8,12 @@
  * of water state variables based on left and right states.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "Core/Isa.hpp"
+#include "Types/CellLayout.hpp"
 #include "Types/RealType.hpp"
 
 namespace Solvers {
@@ -62,7 +68,192 @@ namespace Solvers {
       RealType& o_maxWaveSpeed
     );
 
-    bool Error = false;
+    /**
+     * @brief Computes the net updates of n consecutive edges.
+     *
+     * The states left and right of edge i are at index i of the left and right arrays, its net updates are
+     * written to index i of the output arrays. The results are the same as calling computeNetUpdates for
+     * every edge, but the loop has no branches, so the compiler can vectorise it (SSE/AVX natively,
+     * SIMD128 in the web build). The loop is compiled for every instruction set level, see Core/Isa.hpp.
+     *
+     * @param o_waveSpeeds Scratch space for the wave speeds of the n edges.
+     * @return Maximum wave speed of all edges.
+     */
+    RealType computeNetUpdatesRow(
+      int                       n,
+      const RealType* __restrict hLeft,
+      const RealType* __restrict hRight,
+      const RealType* __restrict huLeft,
+      const RealType* __restrict huRight,
+      const RealType* __restrict bLeft,
+      const RealType* __restrict bRight,
+      RealType* __restrict       o_hUpdateLeft,
+      RealType* __restrict       o_hUpdateRight,
+      RealType* __restrict       o_huUpdateLeft,
+      RealType* __restrict       o_huUpdateRight,
+      RealType* __restrict       o_waveSpeeds
+    );
+
+    /**
+     * @brief Computes the terms of n cells that computeNetUpdates needs on either side of an edge.
+     *
+     * Writes sqrt(h), the celerity sqrt(g h) and the velocity hu / h of cell i to index i of the outputs. A cell
+     * borders two edges of a sweep, with the terms precomputed (see the version below) an edge only needs the
+     * square root of its Roe height. The terms of dry cells (h = 0) are not finite, the edges never use them.
+     */
+    void computeCellTerms(
+      int                        n,
+      const RealType* __restrict h,
+      const RealType* __restrict hu,
+      RealType* __restrict       o_sqrtH,
+      RealType* __restrict       o_celerity,
+      RealType* __restrict       o_velocity
+    );
+
+    /**
+     * @brief Computes the net updates of n consecutive edges with the terms of their cells precomputed.
+     *
+     * Row is SoALayout::Row or CompactBathymetryRow<Format>, the terms of the cells left and right of edge i are
+     * at index i of termsLeft and termsRight (from computeCellTerms). The results are the same as without them.
+     */
+    template <class Row>
+    RealType computeNetUpdatesRow(
+      int                  n,
+      const Row&           left,
+      const Row&           right,
+      const CellTerms&     termsLeft,
+      const CellTerms&     termsRight,
+      RealType* __restrict o_hUpdateLeft,
+      RealType* __restrict o_hUpdateRight,
+      RealType* __restrict o_huUpdateLeft,
+      RealType* __restrict o_huUpdateRight,
+      RealType* __restrict o_waveSpeeds
+    );
+
+    /**
+     * @brief Computes the net updates of n consecutive edges of any cell layout.
+     *
+     * The same as the pointer version, which calls it with SoALayout::Row. The states left and right of edge i
+     * are read with getH(i), getHu(i) and getB(i) of the left and right rows (see Types/CellLayout.hpp). Rows
+     * with the terms of their cells (CellTermsRow) provide them with getSqrtH(i), getCelerity(i) and getVelocity(i).
+     */
+    template <class Row>
+    SWE_FORCE_INLINE RealType computeNetUpdatesRow(
+      int                  n,
+      const Row&           left,
+      const Row&           right,
+      RealType* __restrict o_hUpdateLeft,
+      RealType* __restrict o_hUpdateRight,
+      RealType* __restrict o_huUpdateLeft,
+      RealType* __restrict o_huUpdateRight,
+      RealType* __restrict o_waveSpeeds
+    );
+
+    std::atomic<bool> Error = false; // Set by the rows of a sweep running in parallel
   };
 
+  // Defined in the header, so the loop is compiled (and vectorised) for the row type of every layout. Always
+  // inlined, so it takes the instruction set of its caller.
+  template <class Row>
+  SWE_FORCE_INLINE RealType Fwave::computeNetUpdatesRow(
+    int                  n,
+    const Row&           left,
+    const Row&           right,
+    RealType* __restrict o_hUpdateLeft,
+    RealType* __restrict o_hUpdateRight,
+    RealType* __restrict o_huUpdateLeft,
+    RealType* __restrict o_huUpdateRight,
+    RealType* __restrict o_waveSpeeds
+  ) {
+
+    const RealType g    = 9.81; // Gravitation constant
+    const RealType zero = RealType(0.0);
+
+    // The same steps as computeNetUpdates, with selects instead of branches. Every select depends on a single
+    // comparison, combined conditions (isDryLeft && isDryRight) keep GCC from if-converting the loop. The rows
+    // never overlap the outputs, which GCC cannot tell once the loop is inlined into a variant (see Core/Isa.hpp).
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+    for (int i = 0; i < n; i++) {
+      // All loads are unconditional, so the selects below need no control flow
+      RealType hLeftI   = left.getH(i);
+      RealType hRightI  = right.getH(i);
+      RealType huLeftI  = left.getHu(i);
+      RealType huRightI = right.getHu(i);
+      RealType bLeftI   = left.getB(i);
+      RealType bRightI  = right.getB(i);
+
+      bool isDryLeft  = bLeftI > zero;
+      bool isDryRight = bRightI > zero;
+
+      // Reflect the wet state at dry cells
+      RealType hL  = isDryLeft ? hRightI : hLeftI;
+      RealType hR  = isDryRight ? hLeftI : hRightI;
+      RealType huL = isDryLeft ? -huRightI : huLeftI;
+      RealType huR = isDryRight ? -huLeftI : huRightI;
+      RealType bL  = isDryLeft ? bRightI : bLeftI;
+      RealType bR  = isDryRight ? bLeftI : bRightI;
+
+      // Only a dry-dry edge is left with a dry bathymetry, its results are discarded below
+      bool isDryDry = bL > zero;
+
+      RealType sqrt_hL, sqrt_hR, uL, uR, cL, cR;
+      if constexpr (requires { left.getSqrtH(i); }) {
+        // A reflected state has the terms of the wet cell, with the opposite velocity (negation is exact)
+        sqrt_hL = isDryLeft ? right.getSqrtH(i) : left.getSqrtH(i);
+        sqrt_hR = isDryRight ? left.getSqrtH(i) : right.getSqrtH(i);
+        cL      = isDryLeft ? right.getCelerity(i) : left.getCelerity(i);
+        cR      = isDryRight ? left.getCelerity(i) : right.getCelerity(i);
+        uL      = isDryLeft ? -right.getVelocity(i) : left.getVelocity(i);
+        uR      = isDryRight ? -left.getVelocity(i) : right.getVelocity(i);
+      } else {
+        sqrt_hL = std::sqrt(hL);
+        sqrt_hR = std::sqrt(hR);
+        cL      = std::sqrt(g * hL);
+        cR      = std::sqrt(g * hR);
+        uL      = huL / hL;
+        uR      = huR / hR;
+      }
+
+      RealType uRoe = (sqrt_hL * uL + sqrt_hR * uR) / (sqrt_hL + sqrt_hR);
+      RealType hRoe = RealType(0.5) * (hL + hR);
+      RealType cRoe = std::sqrt(g * hRoe);
+
+      // Selects instead of fmin/fmax vectorise without fast math, they only differ for NaN (invalid states)
+      RealType lambda1 = std::min(uRoe - cRoe, uL - cL);
+      RealType lambda2 = std::max(uRoe + cRoe, uR + cR);
+
+      RealType deltaF0 = huR - huL;
+      RealType deltaF1 = (uR * huR + RealType(0.5) * g * hR * hR) - (uL * huL + RealType(0.5) * g * hL * hL);
+      deltaF1 -= -g * RealType(0.5) * (hL + hR) * (bR - bL);
+
+      RealType denominator = lambda2 - lambda1;
+      RealType alpha1      = (lambda2 * deltaF0 - deltaF1) / denominator;
+      RealType alpha2      = (-lambda1 * deltaF0 + deltaF1) / denominator;
+
+      RealType hUpdateLeft   = (lambda1 < zero ? alpha1 : zero) + (lambda2 < zero ? alpha2 : zero);
+      RealType huUpdateLeft  = (lambda1 < zero ? alpha1 * lambda1 : zero) + (lambda2 < zero ? alpha2 * lambda2 : zero);
+      RealType hUpdateRight  = (lambda1 > zero ? alpha1 : zero) + (lambda2 > zero ? alpha2 : zero);
+      RealType huUpdateRight = (lambda1 > zero ? alpha1 * lambda1 : zero) + (lambda2 > zero ? alpha2 * lambda2 : zero);
+
+      o_hUpdateLeft[i]   = isDryLeft ? zero : hUpdateLeft;
+      o_huUpdateLeft[i]  = isDryLeft ? zero : huUpdateLeft;
+      o_hUpdateRight[i]  = isDryRight ? zero : hUpdateRight;
+      o_huUpdateRight[i] = isDryRight ? zero : huUpdateRight;
+      o_waveSpeeds[i]    = isDryDry ? zero : std::max(std::abs(lambda1), std::abs(lambda2));
+    }
+
+    // A depth that is not positive turns the Roe velocity into NaN (square root of a negative number or
+    // division by zero), so the wave speed of such an edge is NaN. The check is kept out of the loop above.
+    RealType maxWaveSpeed = zero;
+    for (int i = 0; i < n; i++) {
+      if (!(o_waveSpeeds[i] >= zero)) {
+        Error = true;
+      }
+      maxWaveSpeed = o_waveSpeeds[i] > maxWaveSpeed ? o_waveSpeeds[i] : maxWaveSpeed;
+    }
+    return maxWaveSpeed;
+  }
+
 } // namespace Solvers
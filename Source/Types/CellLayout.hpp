@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Types/RealType.hpp"
+
+/**
+ * Numbering of the values stored for every cell
+ */
+enum CellQuantity { QuantityH, QuantityHu, QuantityHv, QuantityB, QuantityCount };
+
+/**
+ * Layout policies for the values of a grid of cols x rows cells, stored in a single array of getSize values.
+ *
+ * getIndex returns the position of a value in the array. Row is a read-only view of the values of consecutive
+ * cells of one row, which the solver reads edge by edge (see Solvers::Fwave::computeNetUpdatesRow).
+ */
+
+/// Structure of arrays: one array per quantity, as Blocks::Block stores its unknowns
+struct SoALayout {
+  static constexpr const char* Name = "SoA";
+
+  static size_t getSize(int cols, int rows) { return size_t(QuantityCount) * cols * rows; }
+
+  static size_t getIndex(int quantity, int x, int y, int cols, int rows) { return (size_t(quantity) * rows + y) * cols + x; }
+
+  struct Row {
+    const RealType* h;
+    const RealType* hu;
+    const RealType* b;
+
+    RealType getH(int i) const { return h[i]; }
+    RealType getHu(int i) const { return hu[i]; }
+    RealType getB(int i) const { return b[i]; }
+  };
+
+  /// Cells from (x, y) on in x-direction, momentum is QuantityHu or QuantityHv
+  static Row getRow(const RealType* data, int momentum, int x, int y, int cols, int rows) {
+    return {data + getIndex(QuantityH, x, y, cols, rows), data + getIndex(momentum, x, y, cols, rows), data + getIndex(QuantityB, x, y, cols, rows)};
+  }
+};
+
+/// Separate arrays with the bathymetry in a 16 bit Format (see Types/CompactFloat.hpp), decoded on every read
+template <class Format>
+struct CompactBathymetryRow {
+  const RealType* h;
+  const RealType* hu;
+  const uint16_t* b;
+
+  RealType getH(int i) const { return h[i]; }
+  RealType getHu(int i) const { return hu[i]; }
+  RealType getB(int i) const { return RealType(Format::decode(b[i])); }
+};
+
+/// Values that every edge of a cell needs: sqrt(h), celerity sqrt(g h) and velocity hu / h of consecutive cells
+struct CellTerms {
+  const RealType* sqrtH;
+  const RealType* celerity;
+  const RealType* velocity;
+};
+
+/// Row of separate arrays (SoALayout::Row or CompactBathymetryRow) with the terms of its cells precomputed
+template <class Row>
+struct CellTermsRow: Row {
+  CellTerms terms;
+
+  RealType getSqrtH(int i) const { return terms.sqrtH[i]; }
+  RealType getCelerity(int i) const { return terms.celerity[i]; }
+  RealType getVelocity(int i) const { return terms.velocity[i]; }
+};
+
+/// Array of structures: the values of a cell are next to each other
+struct AoSLayout {
+  static constexpr const char* Name = "AoS";
+
+  static size_t getSize(int cols, int rows) { return size_t(QuantityCount) * cols * rows; }
+
+  static size_t getIndex(int quantity, int x, int y, int cols, [[maybe_unused]] int rows) { return (size_t(y) * cols + x) * QuantityCount + quantity; }
+
+  struct Row {
+    const RealType* h;
+    const RealType* hu;
+    const RealType* b;
+
+    RealType getH(int i) const { return h[i * QuantityCount]; }
+    RealType getHu(int i) const { return hu[i * QuantityCount]; }
+    RealType getB(int i) const { return b[i * QuantityCount]; }
+  };
+
+  static Row getRow(const RealType* data, int momentum, int x, int y, int cols, int rows) {
+    return {data + getIndex(QuantityH, x, y, cols, rows), data + getIndex(momentum, x, y, cols, rows), data + getIndex(QuantityB, x, y, cols, rows)};
+  }
+};
+
+/**
+ * Array of structures of arrays: tiles of Width cells of a row, each holding Width values per quantity.
+ *
+ * A tile fills a SIMD register per quantity if Width is the vector width. Rows are padded to whole tiles.
+ */
+template <int Width>
+struct AoSoALayout {
+  static_assert(Width > 0 && (Width & (Width - 1)) == 0, "The tile width has to be a power of two");
+
+  static constexpr const char* Name = Width == 2 ? "AoSoA-2" : Width == 4 ? "AoSoA-4" : Width == 8 ? "AoSoA-8" : "AoSoA";
+
+  static int getTiles(int cols) { return (cols + Width - 1) / Width; }
+
+  static size_t getSize(int cols, int rows) { return size_t(QuantityCount) * Width * getTiles(cols) * rows; }
+
+  static size_t getIndex(int quantity, int x, int y, int cols, [[maybe_unused]] int rows) {
+    return ((size_t(y) * getTiles(cols) + x / Width) * QuantityCount + quantity) * Width + x % Width;
+  }
+
+  struct Row {
+    const RealType* row; ///< First tile of the row
+    int             momentum;
+    int             begin;
+
+    static size_t getOffset(int quantity, int x) { return (size_t(x / Width) * QuantityCount + quantity) * Width + x % Width; }
+
+    RealType getH(int i) const { return row[getOffset(QuantityH, begin + i)]; }
+    RealType getHu(int i) const { return row[getOffset(momentum, begin + i)]; }
+    RealType getB(int i) const { return row[getOffset(QuantityB, begin + i)]; }
+  };
+
+  static Row getRow(const RealType* data, int momentum, int x, int y, int cols, [[maybe_unused]] int rows) {
+    return {data + size_t(y) * getTiles(cols) * QuantityCount * Width, momentum, x};
+  }
+};
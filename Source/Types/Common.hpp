@@ -2,7 +2,9 @@
 
 #include "BoundaryEdge.hpp"
 #include "BoundaryType.hpp"
+#include "CompactFloat.hpp"
 #include "Float2D.hpp"
+#include "HeightMapFormat.hpp"
 #include "RealType.hpp"
 #include "ScenarioType.hpp"
 #include "Vec.hpp"
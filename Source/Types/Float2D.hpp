@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdio>
 
 /**
@@ -32,17 +33,28 @@
  * values are sequentially ordered in memory using "column major" order.
  * Besides constructor/deconstructor, the class provides overloading of
  * the []-operator, such that elements can be accessed as a[i][j].
+ *
+ * An array can have a halo of additional elements around it, which are accessed with indices
+ * -halo to -1 and cols (rows) to cols + halo - 1 (rows + halo - 1). a[0][0] stays the first
+ * element without halo, consecutive columns are getStride() elements apart.
  */
 template <class T>
 class Float2D {
 private:
   int rows_;
   int cols_;
+  int halo_;
 
   T* data_;
+  T* memory_; ///< Start of the array incl. halo
 
   bool allocateMemory_;
 
+  void setMemory(T* memory) {
+    memory_ = memory;
+    data_   = memory ? memory + (size_t(halo_) * getStride() + halo_) : nullptr;
+  }
+
 public:
   /**
    * Constructor:
@@ -51,7 +63,9 @@ public:
   Float2D():
     rows_(0),
     cols_(0),
+    halo_(0),
     data_(nullptr),
+    memory_(nullptr),
     allocateMemory_(false) {}
 
   /**
@@ -64,14 +78,36 @@ public:
   Float2D(int cols, int rows, bool allocateMemory = true):
     rows_(rows),
     cols_(cols),
+    halo_(0),
     data_(nullptr),
+    memory_(nullptr),
     allocateMemory_(allocateMemory) {
 
     if (allocateMemory_) {
-      data_ = new T[rows * cols];
+      setMemory(new T[rows * cols]);
     }
   }
 
+  /**
+   * Constructor:
+   * creates a cols x rows array with halo additional elements on each side;
+   * allocates memory for the array unless it is provided via data, but does not initialise values.
+   * @param cols number of columns (i.e., elements in horizontal direction) without halo
+   * @param rows number of rows (i.e., elements in vertical directions) without halo
+   * @param halo width of the halo
+   * @param data optional memory of getAllocatedSize() elements (incl. halo) to be used for the array elements
+   */
+  Float2D(int cols, int rows, int halo, T* data = nullptr):
+    rows_(rows),
+    cols_(cols),
+    halo_(halo),
+    data_(nullptr),
+    memory_(nullptr),
+    allocateMemory_(data == nullptr) {
+
+    setMemory(data ? data : new T[getAllocatedSize()]);
+  }
+
   /**
    * Constructor:
    * takes size of the 2D array as parameters and creates a respective Float2D object;
@@ -84,7 +120,9 @@ public:
   Float2D(int cols, int rows, T* data):
     rows_(rows),
     cols_(cols),
+    halo_(0),
     data_(data),
+    memory_(data),
     allocateMemory_(false) {}
 
   /**
@@ -99,15 +137,16 @@ public:
   Float2D(Float2D<T>& data, bool shallowCopy):
     rows_(data.rows_),
     cols_(data.cols_),
+    halo_(data.halo_),
     allocateMemory_(!shallowCopy) {
 
     if (shallowCopy) {
-      data_           = data.data_;
+      setMemory(data.memory_);
       allocateMemory_ = false;
     } else {
-      data_ = new T[rows_ * cols_];
-      for (int i = 0; i < rows_ * cols_; i++) {
-        data_[i] = data.data_[i];
+      setMemory(new T[getAllocatedSize()]);
+      for (size_t i = 0; i < getAllocatedSize(); i++) {
+        memory_[i] = data.memory_[i];
       }
       allocateMemory_ = true;
     }
@@ -115,27 +154,30 @@ public:
 
   ~Float2D() {
     if (allocateMemory_) {
-      delete[] data_;
+      delete[] memory_;
     }
   }
 
   Float2D& operator=(Float2D&& other) {
     if (this != &other) {
       if (allocateMemory_) {
-        delete[] data_;
+        delete[] memory_;
       }
       rows_           = other.rows_;
       cols_           = other.cols_;
+      halo_           = other.halo_;
       data_           = other.data_;
+      memory_         = other.memory_;
       allocateMemory_ = other.allocateMemory_;
       other.data_     = nullptr;
+      other.memory_   = nullptr;
     }
     return *this;
   }
 
-  T* operator[](int i) { return (data_ + (rows_ * i)); }
+  T* operator[](int i) { return (data_ + (ptrdiff_t(getStride()) * i)); }
 
-  const T* operator[](int i) const { return (data_ + (rows_ * i)); }
+  const T* operator[](int i) const { return (data_ + (ptrdiff_t(getStride()) * i)); }
 
   T* getData() { return data_; }
 
@@ -145,6 +187,14 @@ public:
 
   int getCols() const { return cols_; }
 
+  int getHalo() const { return halo_; }
+
+  /// Distance between the first elements of two consecutive columns
+  int getStride() const { return rows_ + 2 * halo_; }
+
+  /// Number of elements incl. halo
+  size_t getAllocatedSize() const { return size_t(rows_ + 2 * halo_) * (cols_ + 2 * halo_); }
+
   static void toString(const Float2D<T>& toPrint) {
     for (int row = 0; row < toPrint.rows_; row++) {
       for (int col = 0; col < toPrint.cols_; col++) {
@@ -0,0 +1,3 @@
+#pragma once
+
+enum class HeightMapFormat { R32F, R16F, R16, R8, Count };